@@ -0,0 +1,176 @@
+#pragma once
+
+// std library
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace bufferedio
+{
+    constexpr size_t BufferSize = 1 << 20;
+
+    // format value into out (at least 32 bytes), returns the length
+    // integral values take a fast path, others use the shortest of 6 or 9 significant digits that reads back exactly
+    int FormatFloat(float value, char *out)
+    {
+        if (value >= -1e9f && value <= 1e9f && value == std::trunc(value))
+        {
+            int64_t integer = static_cast<int64_t>(value);
+            char digits[24];
+            int digitNum = 0;
+            uint64_t magnitude = integer < 0 ? static_cast<uint64_t>(-integer) : static_cast<uint64_t>(integer);
+            do
+            {
+                digits[digitNum++] = static_cast<char>('0' + magnitude % 10);
+                magnitude /= 10;
+            } while (magnitude != 0);
+
+            int length = 0;
+            if (integer < 0)
+                out[length++] = '-';
+            while (digitNum > 0)
+                out[length++] = digits[--digitNum];
+            out[length] = '\0';
+            return length;
+        }
+
+        int length = std::snprintf(out, 32, "%.6g", value);
+        if (std::strtof(out, nullptr) == value)
+            return length;
+        return std::snprintf(out, 32, "%.9g", value);
+    }
+
+    // append only file writer, data is handed to the C runtime in large blocks
+    class BufferedWriter
+    {
+    public:
+        explicit BufferedWriter(const std::string &filePath)
+        {
+            file = std::fopen(filePath.c_str(), "wb");
+            buffer.reserve(BufferSize);
+        }
+
+        ~BufferedWriter()
+        {
+            Close();
+        }
+
+        BufferedWriter(const BufferedWriter &) = delete;
+        BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+        bool IsOpen() const { return file != nullptr; }
+        bool HasError() const { return hasError; }
+
+        void Write(const char *data, size_t size)
+        {
+            if (buffer.size() + size > BufferSize)
+                Flush();
+            buffer.insert(buffer.end(), data, data + size);
+        }
+
+        void Write(const std::string &str) { Write(str.data(), str.size()); }
+        void Write(const char *str) { Write(str, std::strlen(str)); }
+        void Write(char ch) { Write(&ch, 1); }
+
+        void WriteFloat(float value)
+        {
+            char number[32];
+            Write(number, static_cast<size_t>(FormatFloat(value, number)));
+        }
+
+        void Flush()
+        {
+            if (file != nullptr && !buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size())
+                hasError = true;
+            buffer.clear();
+        }
+
+        bool Close()
+        {
+            if (file == nullptr)
+                return !hasError;
+
+            Flush();
+            if (std::fclose(file) != 0)
+                hasError = true;
+            file = nullptr;
+            return !hasError;
+        }
+
+    private:
+        std::FILE *file = nullptr;
+        std::vector<char> buffer;
+        bool hasError = false;
+    };
+
+    // line reader over large blocks, strips "\n" and "\r\n" line endings
+    class BufferedLineReader
+    {
+    public:
+        explicit BufferedLineReader(const std::string &filePath)
+        {
+            file = std::fopen(filePath.c_str(), "rb");
+            buffer.resize(BufferSize);
+        }
+
+        ~BufferedLineReader()
+        {
+            if (file != nullptr)
+                std::fclose(file);
+        }
+
+        BufferedLineReader(const BufferedLineReader &) = delete;
+        BufferedLineReader &operator=(const BufferedLineReader &) = delete;
+
+        bool IsOpen() const { return file != nullptr; }
+
+        bool ReadLine(std::string &line)
+        {
+            line.clear();
+            while (true)
+            {
+                if (begin == end)
+                {
+                    if (file == nullptr || (end = std::fread(buffer.data(), 1, buffer.size(), file)) == 0)
+                    {
+                        begin = end = 0;
+                        break;
+                    }
+                    begin = 0;
+                }
+
+                const char *first = buffer.data() + begin;
+                const char *newline = static_cast<const char *>(std::memchr(first, '\n', end - begin));
+                if (newline != nullptr)
+                {
+                    line.append(first, newline);
+                    begin += static_cast<size_t>(newline - first) + 1;
+                    StripCarriageReturn(line);
+                    return true;
+                }
+
+                line.append(first, end - begin);
+                begin = end;
+            }
+
+            StripCarriageReturn(line);
+            return !line.empty(); // last line without line ending
+        }
+
+    private:
+        static void StripCarriageReturn(std::string &line)
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+        }
+
+        std::FILE *file = nullptr;
+        std::vector<char> buffer;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+}
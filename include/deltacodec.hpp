@@ -0,0 +1,116 @@
+#pragma once
+
+// std library
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace deltacodec
+{
+    // small magnitudes of either sign map to small unsigned values
+    uint64_t ZigZagEncode(int64_t value)
+    {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    int64_t ZigZagDecode(uint64_t value)
+    {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    // LEB128, 7 bits per byte, low bits first
+    void WriteVarint(std::string &out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    bool ReadVarint(const char *&pos, const char *end, uint64_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos != end; shift += 7)
+        {
+            uint8_t byte = static_cast<uint8_t>(*pos++);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false; // truncated or longer than 10 bytes
+    }
+
+    // float bits as a signed integer with the same ordering as the float, neighbouring values get small deltas
+    int64_t OrderedFloatBits(float value)
+    {
+        int32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits >= 0 ? bits : bits ^ INT32_MAX;
+    }
+
+    float FromOrderedFloatBits(int64_t ordered)
+    {
+        int32_t bits = static_cast<int32_t>(ordered);
+        bits = bits >= 0 ? bits : bits ^ INT32_MAX;
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // values[i] - values[i - 1] as zigzag varints, the first value is stored as is
+    void EncodeDeltas(const int64_t *values, size_t count, std::string &out)
+    {
+        int64_t previous = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            WriteVarint(out, ZigZagEncode(static_cast<int64_t>(static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(previous))));
+            previous = values[i];
+        }
+    }
+
+    // running sum in place, kept apart from the varint decoding so it stays a tight loop
+    // summed as unsigned so it wraps like EncodeDeltas subtracted, corrupt deltas never overflow a signed value
+    void PrefixSum(int64_t *values, size_t count)
+    {
+        uint64_t sum = count > 0 ? static_cast<uint64_t>(values[0]) : 0;
+        size_t i = 1;
+        for (; i + 4 <= count; i += 4)
+        {
+            uint64_t sum0 = sum + static_cast<uint64_t>(values[i]);
+            uint64_t sum1 = sum0 + static_cast<uint64_t>(values[i + 1]);
+            uint64_t sum2 = sum1 + static_cast<uint64_t>(values[i + 2]);
+            sum = sum2 + static_cast<uint64_t>(values[i + 3]);
+            values[i] = static_cast<int64_t>(sum0);
+            values[i + 1] = static_cast<int64_t>(sum1);
+            values[i + 2] = static_cast<int64_t>(sum2);
+            values[i + 3] = static_cast<int64_t>(sum);
+        }
+        for (; i < count; i++)
+        {
+            sum += static_cast<uint64_t>(values[i]);
+            values[i] = static_cast<int64_t>(sum);
+        }
+    }
+
+    bool DecodeDeltas(const char *&pos, const char *end, size_t count, int64_t *values)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (pos != end && (static_cast<uint8_t>(*pos) & 0x80) == 0) // one byte delta, the common case
+            {
+                values[i] = ZigZagDecode(static_cast<uint8_t>(*pos++));
+                continue;
+            }
+
+            uint64_t value;
+            if (!ReadVarint(pos, end, value))
+                return false;
+            values[i] = ZigZagDecode(value);
+        }
+
+        PrefixSum(values, count);
+        return true;
+    }
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+// imgui [draw list internals]
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+
+// std library
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace drawcache
+{
+    // bumped when something every block depends on changes, the font atlas layout or the style sizes
+    uint64_t Generation = 0;
+
+    void Invalidate() { Generation++; }
+
+    // geometry a static block of widgets drew, replayed while its content version and placement do not change
+    // vertices are kept at the position they were captured at, indices relative to the first vertex
+    struct Block
+    {
+        bool isValid = false;
+        uint64_t version = 0;
+        uint64_t generation = 0;
+        ImVec2 origin;     // cursor screen position at capture
+        ImVec4 clipRect;   // draw list clip rect at capture, relative to origin
+        ImTextureID textureId = nullptr;
+        ImVec2 size;       // layout size of the block, reserved again on replay
+        std::vector<ImDrawVert> vertices;
+        std::vector<ImDrawIdx> indices;
+    };
+
+    // inner state of an open Begin, blocks may nest
+    struct Capture
+    {
+        Block *block = nullptr; // nullptr when replayed or not cached
+        ImDrawList *drawList = nullptr;
+        int cmdNum = 0;
+        int vtxBegin = 0;
+        int idxBegin = 0;
+        unsigned int vtxCurrentIdx = 0;
+    };
+
+    struct Context
+    {
+        std::unordered_map<ImGuiID, Block> blocks;
+        std::vector<Capture> captures;
+    };
+
+    Context &GlobalContext()
+    {
+        static Context context;
+        return context;
+    }
+
+    // FNV-1a of a text, a content version for blocks showing it
+    uint64_t HashText(const char *text)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (; *text != '\0'; text++)
+        {
+            hash ^= static_cast<unsigned char>(*text);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // inner function
+    static ImVec4 RelativeClipRect(const ImVec4 &clipRect, const ImVec2 &origin)
+    {
+        return ImVec4(clipRect.x - origin.x, clipRect.y - origin.y, clipRect.z - origin.x, clipRect.w - origin.y);
+    }
+
+    static bool IsSameRect(const ImVec4 &a, const ImVec4 &b)
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+    }
+
+    // appends the cached geometry moved to the current cursor and reserves its layout size
+    static void Replay(ImDrawList *drawList, const Block &block, const ImVec2 &origin)
+    {
+        int vtxNum = static_cast<int>(block.vertices.size());
+        int idxNum = static_cast<int>(block.indices.size());
+        if (idxNum > 0)
+        {
+            drawList->PrimReserve(idxNum, vtxNum); // may start a new VtxOffset, so the base index is read after it
+            ImDrawIdx base = static_cast<ImDrawIdx>(drawList->_VtxCurrentIdx);
+            ImVec2 delta(origin.x - block.origin.x, origin.y - block.origin.y);
+            ImDrawVert *vtxWrite = drawList->_VtxWritePtr;
+            for (const ImDrawVert &it : block.vertices)
+            {
+                *vtxWrite = it;
+                vtxWrite->pos.x += delta.x;
+                vtxWrite->pos.y += delta.y;
+                vtxWrite++;
+            }
+            ImDrawIdx *idxWrite = drawList->_IdxWritePtr;
+            for (ImDrawIdx it : block.indices)
+                *idxWrite++ = static_cast<ImDrawIdx>(base + it);
+            drawList->_VtxWritePtr = vtxWrite;
+            drawList->_IdxWritePtr = idxWrite;
+            drawList->_VtxCurrentIdx += static_cast<unsigned int>(vtxNum);
+        }
+        ImGui::Dummy(block.size);
+    }
+
+    // start a block of static widgets at the cursor, strId is unique in the window
+    // false when the cached geometry was replayed and the widgets must be skipped, End is called either way
+    // only for widgets without interaction (text, separators), and the block must not change clip rect or texture
+    bool Begin(const char *strId, uint64_t version)
+    {
+        Context &context = GlobalContext();
+        ImGuiWindow *window = ImGui::GetCurrentWindow();
+        context.captures.emplace_back();
+        Capture &capture = context.captures.back();
+        if (window->SkipItems)
+            return true;
+
+        ImDrawList *drawList = window->DrawList;
+        Block &block = context.blocks[window->GetID(strId)];
+        ImVec2 origin = window->DC.CursorPos;
+        if (block.isValid && block.version == version && block.generation == Generation && block.textureId == drawList->_CmdHeader.TextureId &&
+            IsSameRect(block.clipRect, RelativeClipRect(drawList->_CmdHeader.ClipRect, origin)))
+        {
+            Replay(drawList, block, origin);
+            return false;
+        }
+
+        block.isValid = false;
+        block.version = version;
+        block.generation = Generation;
+        block.origin = origin;
+        block.clipRect = RelativeClipRect(drawList->_CmdHeader.ClipRect, origin);
+        block.textureId = drawList->_CmdHeader.TextureId;
+        capture.block = &block;
+        capture.drawList = drawList;
+        capture.cmdNum = drawList->CmdBuffer.Size;
+        capture.vtxBegin = drawList->VtxBuffer.Size;
+        capture.idxBegin = drawList->IdxBuffer.Size;
+        capture.vtxCurrentIdx = drawList->_VtxCurrentIdx;
+        ImGui::BeginGroup();
+        return true;
+    }
+
+    // close the block, a block drawn this frame is captured unless it split into several draw commands
+    void End()
+    {
+        Context &context = GlobalContext();
+        IM_ASSERT(!context.captures.empty() && "drawcache::End without Begin");
+        Capture capture = context.captures.back();
+        context.captures.pop_back();
+        if (capture.block == nullptr)
+            return;
+
+        ImGui::EndGroup();
+        Block &block = *capture.block;
+        ImDrawList *drawList = capture.drawList;
+        block.size = ImGui::GetItemRectSize();
+        if (drawList->CmdBuffer.Size != capture.cmdNum || drawList->_VtxCurrentIdx < capture.vtxCurrentIdx)
+            return; // drawn with another clip rect, texture or vertex offset, drawn every frame
+
+        block.vertices.assign(drawList->VtxBuffer.Data + capture.vtxBegin, drawList->VtxBuffer.Data + drawList->VtxBuffer.Size);
+        block.indices.resize(static_cast<size_t>(drawList->IdxBuffer.Size - capture.idxBegin));
+        for (size_t i = 0; i < block.indices.size(); i++)
+            block.indices[i] = static_cast<ImDrawIdx>(drawList->IdxBuffer[capture.idxBegin + static_cast<int>(i)] - capture.vtxCurrentIdx);
+        block.isValid = true;
+    }
+}
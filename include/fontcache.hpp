@@ -0,0 +1,288 @@
+#pragma once
+
+// imgui [font atlas internals]
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+
+// std library
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fontcache
+{
+    const char CacheMagic[4] = {'P', 'C', 'F', 'A'};
+    constexpr uint32_t CacheVersion = 1;
+
+    // baked atlas file, set before the atlas is built
+    std::string CachePath = "PorchFont.cache";
+
+    // the latest bake when it is not in CachePath yet, Flush writes it so a burst of rebakes writes the file once
+    bool IsCacheDirty = false;
+    uint64_t DirtyKey = 0;
+
+    // font file bytes hashed once by PinFontData, the owner keeps them alive and unchanged
+    struct PinnedData
+    {
+        const void *data = nullptr;
+        size_t size = 0;
+        uint64_t hash = 0;
+    };
+    PinnedData PinnedFont;
+
+    // inner function
+    static uint64_t HashBytes(const void *data, size_t size, uint64_t hash)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    template <class T>
+    static uint64_t HashValue(const T &value, uint64_t hash)
+    {
+        return HashBytes(&value, sizeof(value), hash);
+    }
+
+    // a multi-megabyte CJK font is not hashed again on every rebake
+    void PinFontData(const void *data, size_t size)
+    {
+        PinnedFont.data = data;
+        PinnedFont.size = size;
+        PinnedFont.hash = HashBytes(data, size, 14695981039346656037ull);
+    }
+
+    // everything the baked pixels and glyph tables depend on: font file contents, size, glyph ranges and atlas options
+    uint64_t AtlasKey(const ImFontAtlas *atlas)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        hash = HashValue(static_cast<int>(IMGUI_VERSION_NUM), hash);
+        hash = HashValue(atlas->Flags, hash);
+        hash = HashValue(atlas->TexDesiredWidth, hash);
+        hash = HashValue(atlas->TexGlyphPadding, hash);
+        hash = HashValue(atlas->FontBuilderFlags, hash);
+        for (const ImFontConfig &cfg : atlas->ConfigData)
+        {
+            if (cfg.FontData != nullptr && cfg.FontData == PinnedFont.data && static_cast<size_t>(cfg.FontDataSize) == PinnedFont.size)
+                hash = HashValue(PinnedFont.hash, hash);
+            else
+                hash = HashBytes(cfg.FontData, static_cast<size_t>(cfg.FontDataSize), hash);
+            hash = HashValue(cfg.FontNo, hash);
+            hash = HashValue(cfg.SizePixels, hash);
+            hash = HashValue(cfg.OversampleH, hash);
+            hash = HashValue(cfg.OversampleV, hash);
+            hash = HashValue(cfg.PixelSnapH, hash);
+            hash = HashValue(cfg.GlyphExtraSpacing, hash);
+            hash = HashValue(cfg.GlyphOffset, hash);
+            hash = HashValue(cfg.GlyphMinAdvanceX, hash);
+            hash = HashValue(cfg.GlyphMaxAdvanceX, hash);
+            hash = HashValue(cfg.MergeMode, hash);
+            hash = HashValue(cfg.FontBuilderFlags, hash);
+            hash = HashValue(cfg.RasterizerMultiply, hash);
+            hash = HashValue(cfg.EllipsisChar, hash);
+            for (const ImWchar *range = cfg.GlyphRanges; range != nullptr && range[0] != 0; range += 2)
+            {
+                hash = HashValue(range[0], hash);
+                hash = HashValue(range[1], hash);
+            }
+        }
+        return hash;
+    }
+
+    // inner function
+    template <class T>
+    static void Write(std::ofstream &outStream, const T &value)
+    {
+        outStream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    template <class T>
+    static bool Read(std::ifstream &inStream, T &value)
+    {
+        return static_cast<bool>(inStream.read(reinterpret_cast<char *>(&value), sizeof(value)));
+    }
+
+    // baked atlas: texture pixels, packed custom rects and every font's metrics and glyphs
+    bool SaveAtlas(const ImFontAtlas *atlas, uint64_t key, const std::string &path)
+    {
+        if (atlas->TexPixelsAlpha8 == nullptr)
+            return false;
+
+        std::ofstream outStream;
+        outStream.open(path, std::ios::out | std::ios::binary); // overwrite the file
+        if (!outStream)
+            return false;
+
+        outStream.write(CacheMagic, sizeof(CacheMagic));
+        Write(outStream, CacheVersion);
+        Write(outStream, key);
+        Write(outStream, atlas->TexWidth);
+        Write(outStream, atlas->TexHeight);
+
+        Write(outStream, static_cast<uint32_t>(atlas->CustomRects.Size));
+        for (const ImFontAtlasCustomRect &rect : atlas->CustomRects)
+        {
+            Write(outStream, rect.Width);
+            Write(outStream, rect.Height);
+            Write(outStream, rect.X);
+            Write(outStream, rect.Y);
+        }
+
+        Write(outStream, static_cast<uint32_t>(atlas->Fonts.Size));
+        for (const ImFont *font : atlas->Fonts)
+        {
+            // glyphs of custom rects are added again by ImFontAtlasBuildFinish
+            auto isCustom = [atlas, font](const ImFontGlyph &glyph) {
+                for (const ImFontAtlasCustomRect &rect : atlas->CustomRects)
+                {
+                    if (rect.Font == font && rect.GlyphID == glyph.Codepoint)
+                        return true;
+                }
+                return false;
+            };
+
+            uint32_t glyphNum = static_cast<uint32_t>(font->Glyphs.Size - std::count_if(font->Glyphs.begin(), font->Glyphs.end(), isCustom));
+
+            Write(outStream, font->Ascent);
+            Write(outStream, font->Descent);
+            Write(outStream, glyphNum);
+            for (const ImFontGlyph &glyph : font->Glyphs)
+            {
+                if (isCustom(glyph))
+                    continue;
+                float values[] = {glyph.X0, glyph.Y0, glyph.X1, glyph.Y1, glyph.U0, glyph.V0, glyph.U1, glyph.V1, glyph.AdvanceX};
+                Write(outStream, static_cast<uint32_t>(glyph.Codepoint));
+                Write(outStream, values);
+            }
+        }
+
+        outStream.write(reinterpret_cast<const char *>(atlas->TexPixelsAlpha8), static_cast<std::streamsize>(atlas->TexWidth) * atlas->TexHeight);
+        outStream.close();
+        return static_cast<bool>(outStream);
+    }
+
+    // fill the atlas from the cache file, false when it is missing, stale or does not fit the atlas
+    bool LoadAtlas(ImFontAtlas *atlas, uint64_t key, const std::string &path)
+    {
+        std::ifstream inStream;
+        inStream.open(path, std::ios::in | std::ios::binary);
+        if (!inStream)
+            return false;
+
+        char magic[sizeof(CacheMagic)];
+        uint32_t version = 0;
+        uint64_t fileKey = 0;
+        int texWidth = 0, texHeight = 0;
+        if (!inStream.read(magic, sizeof(magic)) || std::memcmp(magic, CacheMagic, sizeof(magic)) != 0 ||
+            !Read(inStream, version) || version != CacheVersion || !Read(inStream, fileKey) || fileKey != key ||
+            !Read(inStream, texWidth) || !Read(inStream, texHeight) || texWidth <= 0 || texHeight <= 0 || texWidth > 1 << 15 || texHeight > 1 << 15)
+            return false;
+
+        // the default rects registered by ImFontAtlasBuildInit must match the cached ones
+        ImFontAtlasBuildInit(atlas);
+        uint32_t rectNum = 0;
+        if (!Read(inStream, rectNum) || rectNum != static_cast<uint32_t>(atlas->CustomRects.Size))
+            return false;
+        std::vector<ImFontAtlasCustomRect> rects(atlas->CustomRects.begin(), atlas->CustomRects.end());
+        for (auto &rect : rects)
+        {
+            unsigned short width = 0, height = 0;
+            if (!Read(inStream, width) || !Read(inStream, height) || !Read(inStream, rect.X) || !Read(inStream, rect.Y) ||
+                width != rect.Width || height != rect.Height)
+                return false;
+        }
+
+        uint32_t fontNum = 0;
+        if (!Read(inStream, fontNum) || fontNum != static_cast<uint32_t>(atlas->Fonts.Size))
+            return false;
+        std::vector<float> ascents(fontNum), descents(fontNum);
+        std::vector<std::vector<std::pair<uint32_t, std::array<float, 9>>>> glyphs(fontNum);
+        for (uint32_t i = 0; i < fontNum; i++)
+        {
+            uint32_t glyphNum = 0;
+            if (!Read(inStream, ascents[i]) || !Read(inStream, descents[i]) || !Read(inStream, glyphNum) || glyphNum > 1 << 21)
+                return false;
+            glyphs[i].resize(glyphNum);
+            for (auto &glyph : glyphs[i])
+            {
+                if (!Read(inStream, glyph.first) || !Read(inStream, glyph.second))
+                    return false;
+            }
+        }
+
+        size_t pixelNum = static_cast<size_t>(texWidth) * static_cast<size_t>(texHeight);
+        unsigned char *pixels = static_cast<unsigned char *>(IM_ALLOC(pixelNum));
+        if (!inStream.read(reinterpret_cast<char *>(pixels), static_cast<std::streamsize>(pixelNum)))
+        {
+            IM_FREE(pixels);
+            return false;
+        }
+
+        // same state ImFontAtlasBuildWithStbTruetype leaves behind
+        atlas->TexID = (ImTextureID)NULL;
+        atlas->ClearTexData();
+        atlas->TexPixelsAlpha8 = pixels;
+        atlas->TexWidth = texWidth;
+        atlas->TexHeight = texHeight;
+        atlas->TexUvScale = ImVec2(1.0f / texWidth, 1.0f / texHeight);
+        for (int i = 0; i < atlas->CustomRects.Size; i++)
+        {
+            atlas->CustomRects[i].X = rects[i].X;
+            atlas->CustomRects[i].Y = rects[i].Y;
+        }
+
+        for (ImFontConfig &cfg : atlas->ConfigData)
+        {
+            int fontIndex = atlas->Fonts.index_from_ptr(std::find(atlas->Fonts.begin(), atlas->Fonts.end(), cfg.DstFont));
+            ImFontAtlasBuildSetupFont(atlas, cfg.DstFont, &cfg, ascents[fontIndex], descents[fontIndex]);
+        }
+        for (uint32_t i = 0; i < fontNum; i++)
+        {
+            ImFont *font = atlas->Fonts[static_cast<int>(i)];
+            for (auto &glyph : glyphs[i])
+            {
+                const std::array<float, 9> &v = glyph.second;
+                font->AddGlyph(nullptr, static_cast<ImWchar>(glyph.first), v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8]);
+            }
+        }
+
+        ImFontAtlasBuildFinish(atlas);
+        return true;
+    }
+
+    // atlas builder that reuses the cached bake when the key matches and rasterizes with stb_truetype otherwise
+    bool BuildAtlas(ImFontAtlas *atlas)
+    {
+        uint64_t key = AtlasKey(atlas);
+        if (LoadAtlas(atlas, key, CachePath))
+        {
+            IsCacheDirty = false;
+            return true;
+        }
+
+        if (!ImFontAtlasGetBuilderForStbTruetype()->FontBuilder_Build(atlas))
+            return false;
+        IsCacheDirty = true;
+        DirtyKey = key;
+        return true;
+    }
+
+    // write the latest bake, the atlas must still hold it
+    void Flush(const ImFontAtlas *atlas)
+    {
+        if (!IsCacheDirty)
+            return;
+        IsCacheDirty = false;
+        SaveAtlas(atlas, DirtyKey, CachePath); // a failed write only costs the next start a rebake
+    }
+
+    const ImFontBuilderIO CachedBuilderIO = {BuildAtlas};
+}
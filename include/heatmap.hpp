@@ -0,0 +1,373 @@
+#pragma once
+
+// imgui [map drawing]
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+
+// std library
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace heatmap
+{
+    constexpr int TileSize = 32;       // cells per tile side, a tile is the unit of work and of caching
+    constexpr int UniformQuadSize = 4; // largest quad filled from its corners, a feature narrower than this between samples can be missed
+    constexpr uint8_t Unknown = 0xFF;  // cell not evaluated yet
+
+    // floor(value / divisor) for negative values too, divisor > 0
+    int64_t FloorDiv(int64_t value, int64_t divisor)
+    {
+        return value >= 0 ? value / divisor : -((-value - 1) / divisor) - 1;
+    }
+
+    // tiles are aligned on a grid of integer sample points, a cell at level l is a sample every 2^l grid units
+    // so a pan reuses the tiles next to the old view and a zoom by 2 reuses every other sample of the next level
+    struct TileKey
+    {
+        int xLevel = 0;
+        int yLevel = 0;
+        int64_t x = 0; // tile index, its first cell is x * TileSize at its level
+        int64_t y = 0;
+
+        bool operator==(const TileKey &other) const
+        {
+            return xLevel == other.xLevel && yLevel == other.yLevel && x == other.x && y == other.y;
+        }
+    };
+
+    struct TileKeyHash
+    {
+        size_t operator()(const TileKey &key) const
+        {
+            uint64_t hash = static_cast<uint64_t>(key.x) * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(key.y) * 0xC2B2AE3D27D4EB4Full;
+            hash ^= static_cast<uint64_t>(key.xLevel) << 56 ^ static_cast<uint64_t>(key.yLevel) << 48;
+            return static_cast<size_t>(hash ^ hash >> 29);
+        }
+    };
+
+    // class of every cell of a tile, row j at j * TileSize, Unknown until evaluated or filled
+    struct Tile
+    {
+        TileKey key;
+        std::vector<uint8_t> cells;
+        size_t evaluatedNum = 0; // samples the worker computed, cells copied from other levels or filled from corners not counted
+        uint64_t lastUsed = 0;   // frame the tile was last drawn, the least recently drawn ones are evicted
+
+        explicit Tile(const TileKey &key = TileKey()) : key(key), cells(TileSize * TileSize, Unknown) {}
+
+        int64_t GridX(int i) const { return (key.x * TileSize + i) * (int64_t(1) << key.xLevel); }
+        int64_t GridY(int j) const { return (key.y * TileSize + j) * (int64_t(1) << key.yLevel); }
+    };
+
+    // inner function, cell of a tile axis sampling grid point value, false when no cell does
+    static bool ToCell(int64_t grid, int64_t tile, int level, int &cell)
+    {
+        int64_t step = int64_t(1) << level;
+        int64_t index = FloorDiv(grid, step);
+        if (index * step != grid || index < tile * TileSize || index >= (tile + 1) * TileSize)
+            return false;
+        cell = static_cast<int>(index - tile * TileSize);
+        return true;
+    }
+
+    // copy the cells of src that sample the same grid points as unknown cells of dst, src is usually its parent or a child
+    void Seed(Tile &dst, const Tile &src)
+    {
+        for (int j = 0; j < TileSize; j++)
+        {
+            int cellY = 0;
+            if (!ToCell(src.GridY(j), dst.key.y, dst.key.yLevel, cellY))
+                continue;
+            for (int i = 0; i < TileSize; i++)
+            {
+                int cellX = 0;
+                uint8_t value = src.cells[j * TileSize + i];
+                if (value != Unknown && ToCell(src.GridX(i), dst.key.x, dst.key.xLevel, cellX) && dst.cells[cellY * TileSize + cellX] == Unknown)
+                    dst.cells[cellY * TileSize + cellX] = value;
+            }
+        }
+    }
+
+    // inner function, a quad whose corners and known cells agree is filled, any other is split until single cells remain
+    template <class Sample>
+    static void RefineQuad(Tile &tile, int i0, int j0, int size, Sample &sample)
+    {
+        uint8_t value = sample(i0, j0);
+        if (size == 1)
+            return;
+
+        bool isUniform = sample(i0 + size, j0) == value && sample(i0, j0 + size) == value && sample(i0 + size, j0 + size) == value;
+        for (int j = j0; isUniform && j < j0 + size; j++)
+        {
+            for (int i = i0; isUniform && i < i0 + size; i++)
+            {
+                uint8_t cell = tile.cells[j * TileSize + i];
+                isUniform = cell == Unknown || cell == value; // a cell seeded from another level can show a feature the corners miss
+            }
+        }
+        if (isUniform)
+        {
+            for (int j = j0; j < j0 + size; j++)
+            {
+                for (int i = i0; i < i0 + size; i++)
+                {
+                    if (tile.cells[j * TileSize + i] == Unknown)
+                        tile.cells[j * TileSize + i] = value;
+                }
+            }
+            return;
+        }
+
+        int half = size / 2;
+        RefineQuad(tile, i0, j0, half, sample);
+        RefineQuad(tile, i0 + half, j0, half, sample);
+        RefineQuad(tile, i0, j0 + half, half, sample);
+        RefineQuad(tile, i0 + half, j0 + half, half, sample);
+    }
+
+    // evaluate the unknown cells of a tile coarse to fine, classify(gridX, gridY) returns the class of a sample point
+    // samples are only taken along boundaries between classes, uniform regions cost the corners of their quads
+    template <class Classify>
+    void Refine(Tile &tile, Classify &classify)
+    {
+        auto sample = [&tile, &classify](int i, int j) -> uint8_t {
+            if (i >= TileSize || j >= TileSize)
+            {
+                tile.evaluatedNum++;
+                return classify(tile.GridX(i), tile.GridY(j)); // corner on the next tile, not kept
+            }
+            uint8_t &cell = tile.cells[j * TileSize + i];
+            if (cell == Unknown)
+            {
+                cell = classify(tile.GridX(i), tile.GridY(j));
+                tile.evaluatedNum++;
+            }
+            return cell;
+        };
+        for (int j = 0; j < TileSize; j += UniformQuadSize)
+        {
+            for (int i = 0; i < TileSize; i += UniformQuadSize)
+                RefineQuad(tile, i, j, UniformQuadSize, sample);
+        }
+    }
+
+    // tiles workers finished, taken over by the UI thread once per frame so the cache is only touched there
+    class TileQueue
+    {
+    public:
+        void Push(Tile &&tile)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(std::move(tile));
+        }
+
+        void Drain(std::vector<Tile> &tiles)
+        {
+            tiles.clear();
+            std::lock_guard<std::mutex> lock(mutex);
+            tiles.swap(pending);
+        }
+
+    private:
+        std::mutex mutex;
+        std::vector<Tile> pending;
+    };
+
+    // every tile computed for the current inputs at any level, kept across pans and zooms
+    class TileCache
+    {
+    public:
+        void Clear() { tiles.clear(); }
+        size_t Size() const { return tiles.size(); }
+
+        Tile *Find(const TileKey &key)
+        {
+            auto it = tiles.find(key);
+            return it != tiles.end() ? &it->second : nullptr;
+        }
+
+        void Insert(Tile &&tile)
+        {
+            TileKey key = tile.key;
+            tiles[key] = std::move(tile);
+        }
+
+        // drop the least recently drawn tiles until keepNum are left
+        void Evict(size_t keepNum)
+        {
+            if (tiles.size() <= keepNum)
+                return;
+            std::vector<std::pair<uint64_t, TileKey>> ages;
+            ages.reserve(tiles.size());
+            for (const auto &it : tiles)
+                ages.emplace_back(it.second.lastUsed, it.first);
+            std::nth_element(ages.begin(), ages.begin() + static_cast<ptrdiff_t>(tiles.size() - keepNum), ages.end(),
+                             [](const std::pair<uint64_t, TileKey> &a, const std::pair<uint64_t, TileKey> &b) { return a.first < b.first; });
+            for (size_t i = 0; i < ages.size() - keepNum; i++)
+                tiles.erase(ages[i].second);
+        }
+
+        // classes of cells [x0, x0 + width) x [y0, y0 + height) at the given levels, row 0 is y0
+        // a cell not computed at these levels shows the sample at or below it from up to maxUp coarser levels
+        void Read(int xLevel, int yLevel, int64_t x0, int64_t y0, int width, int height, int maxUp, uint64_t frame, std::vector<uint8_t> &cells)
+        {
+            cells.assign(static_cast<size_t>(width) * static_cast<size_t>(height), Unknown);
+            std::vector<Tile *> chain(static_cast<size_t>(maxUp) + 1);
+            for (int64_t tileY = FloorDiv(y0, TileSize); tileY * TileSize < y0 + height; tileY++)
+            {
+                for (int64_t tileX = FloorDiv(x0, TileSize); tileX * TileSize < x0 + width; tileX++)
+                {
+                    // a tile at k levels up covers the whole tile, so its ancestors are looked up once
+                    bool isAny = false;
+                    for (int k = 0; k <= maxUp; k++)
+                    {
+                        TileKey key;
+                        key.xLevel = xLevel + k;
+                        key.yLevel = yLevel + k;
+                        key.x = FloorDiv(tileX, int64_t(1) << k);
+                        key.y = FloorDiv(tileY, int64_t(1) << k);
+                        chain[k] = Find(key);
+                        if (chain[k] != nullptr)
+                        {
+                            chain[k]->lastUsed = frame;
+                            isAny = true;
+                        }
+                    }
+                    if (!isAny)
+                        continue;
+
+                    int64_t cellY0 = std::max(y0, tileY * TileSize), cellY1 = std::min(y0 + height, (tileY + 1) * TileSize);
+                    int64_t cellX0 = std::max(x0, tileX * TileSize), cellX1 = std::min(x0 + width, (tileX + 1) * TileSize);
+                    for (int64_t cellY = cellY0; cellY < cellY1; cellY++)
+                    {
+                        for (int64_t cellX = cellX0; cellX < cellX1; cellX++)
+                        {
+                            uint8_t value = Unknown;
+                            for (int k = 0; k <= maxUp && value == Unknown; k++)
+                            {
+                                if (chain[k] == nullptr)
+                                    continue;
+                                int64_t i = FloorDiv(cellX, int64_t(1) << k) - chain[k]->key.x * TileSize;
+                                int64_t j = FloorDiv(cellY, int64_t(1) << k) - chain[k]->key.y * TileSize;
+                                value = chain[k]->cells[static_cast<size_t>(j * TileSize + i)];
+                            }
+                            cells[static_cast<size_t>((cellY - y0) * width + (cellX - x0))] = value;
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        std::unordered_map<TileKey, Tile, TileKeyHash> tiles;
+    };
+
+    // visible part of the map in input values, y grows upwards
+    struct View
+    {
+        double xMin = 0.0;
+        double xMax = 0.0;
+        double yMin = 0.0;
+        double yMax = 0.0;
+    };
+
+    // inner function, keep the span of an axis within [minSpan, maxSpan] around its center
+    static void ClampSpan(double &min, double &max, double minSpan, double maxSpan)
+    {
+        double span = std::max(minSpan, std::min(max - min, maxSpan));
+        double center = (min + max) / 2;
+        min = center - span / 2;
+        max = center + span / 2;
+    }
+
+    // map of a texture laid over image (in input values), drawn clipped to the plot
+    // dragging pans, the wheel zooms around the mouse, a double click returns to home; marker is drawn as a cross
+    // returns true while the mouse is over the map, value is then the input values under it
+    bool PlotMap(const char *label, View &view, const View &home, const ImVec2 &minSpan, ImTextureID texture, const View &image, const ImVec2 &marker, const ImVec2 &size, ImVec2 &value)
+    {
+        ImGuiWindow *window = ImGui::GetCurrentWindow();
+        if (window->SkipItems)
+            return false;
+
+        const ImGuiStyle &style = ImGui::GetStyle();
+        ImVec2 frameSize = ImGui::CalcItemSize(size, ImGui::CalcItemWidth(), ImGui::GetTextLineHeight() * 8 + style.FramePadding.y * 2);
+        ImRect frame(window->DC.CursorPos, ImVec2(window->DC.CursorPos.x + frameSize.x, window->DC.CursorPos.y + frameSize.y));
+        ImRect inner(ImVec2(frame.Min.x + style.FramePadding.x, frame.Min.y + style.FramePadding.y), ImVec2(frame.Max.x - style.FramePadding.x, frame.Max.y - style.FramePadding.y));
+        ImGuiID id = window->GetID(label);
+        ImGui::ItemSize(frame, style.FramePadding.y);
+        if (!ImGui::ItemAdd(frame, id))
+            return false;
+        bool isHovered = false, isHeld = false;
+        ImGui::ButtonBehavior(frame, id, &isHovered, &isHeld); // held while dragging, so the window does not move instead
+        if (inner.GetWidth() <= 0.0f || inner.GetHeight() <= 0.0f)
+            return isHovered;
+
+        ImGuiIO &io = ImGui::GetIO();
+        double scaleX = (view.xMax - view.xMin) / inner.GetWidth(), scaleY = (view.yMax - view.yMin) / inner.GetHeight();
+        if (isHeld && (io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f))
+        {
+            view.xMin -= io.MouseDelta.x * scaleX;
+            view.xMax -= io.MouseDelta.x * scaleX;
+            view.yMin += io.MouseDelta.y * scaleY;
+            view.yMax += io.MouseDelta.y * scaleY;
+        }
+        if (isHovered && io.MouseWheel != 0.0f)
+        {
+            double anchorX = view.xMin + (io.MousePos.x - inner.Min.x) * scaleX;
+            double anchorY = view.yMax - (io.MousePos.y - inner.Min.y) * scaleY;
+            double scale = io.MouseWheel > 0.0f ? 0.8 : 1.25;
+            view.xMin = anchorX - (anchorX - view.xMin) * scale;
+            view.xMax = anchorX + (view.xMax - anchorX) * scale;
+            view.yMin = anchorY - (anchorY - view.yMin) * scale;
+            view.yMax = anchorY + (view.yMax - anchorY) * scale;
+        }
+        if (isHovered)
+            ImGui::SetKeyOwner(ImGuiKey_MouseWheelY, id); // from the next frame on the window does not scroll with the map
+        if (isHovered && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+            view = home;
+        ClampSpan(view.xMin, view.xMax, minSpan.x, 1e9);
+        ClampSpan(view.yMin, view.yMax, minSpan.y, 1e9);
+        scaleX = (view.xMax - view.xMin) / inner.GetWidth();
+        scaleY = (view.yMax - view.yMin) / inner.GetHeight();
+
+        auto toScreen = [&](double x, double y) {
+            return ImVec2(inner.Min.x + static_cast<float>((x - view.xMin) / scaleX), inner.Max.y - static_cast<float>((y - view.yMin) / scaleY));
+        };
+
+        ImDrawList *drawList = window->DrawList;
+        drawList->AddRectFilled(frame.Min, frame.Max, ImGui::GetColorU32(ImGuiCol_FrameBg), style.FrameRounding);
+        drawList->PushClipRect(inner.Min, inner.Max, true);
+        if (texture != nullptr)
+            drawList->AddImage(texture, toScreen(image.xMin, image.yMax), toScreen(image.xMax, image.yMin)); // texture row 0 is the top
+        ImVec2 center = toScreen(marker.x, marker.y);
+        float arm = ImGui::GetTextLineHeight() * 0.5f;
+        drawList->AddLine(ImVec2(center.x - arm, center.y), ImVec2(center.x + arm, center.y), IM_COL32(255, 255, 255, 255), 2.0f);
+        drawList->AddLine(ImVec2(center.x, center.y - arm), ImVec2(center.x, center.y + arm), IM_COL32(255, 255, 255, 255), 2.0f);
+        drawList->PopClipRect();
+
+        // axis values in the corners
+        char text[64];
+        ImU32 textColor = ImGui::GetColorU32(ImGuiCol_Text);
+        ImFormatString(text, sizeof(text), "%.6g", view.yMax);
+        drawList->AddText(inner.Min, textColor, text);
+        ImFormatString(text, sizeof(text), "%.6g", view.yMin);
+        drawList->AddText(ImVec2(inner.Min.x, inner.Max.y - ImGui::GetTextLineHeight()), textColor, text);
+        ImFormatString(text, sizeof(text), "%.6g .. %.6g", view.xMin, view.xMax);
+        drawList->AddText(ImVec2(inner.Max.x - ImGui::CalcTextSize(text).x, inner.Max.y - ImGui::GetTextLineHeight()), textColor, text);
+        drawList->AddText(ImVec2(inner.Max.x - ImGui::CalcTextSize(label, nullptr, true).x, inner.Min.y), textColor, label, ImGui::FindRenderedTextEnd(label));
+
+        if (isHovered && inner.Contains(io.MousePos))
+        {
+            value.x = static_cast<float>(view.xMin + (io.MousePos.x - inner.Min.x) * scaleX);
+            value.y = static_cast<float>(view.yMax - (io.MousePos.y - inner.Min.y) * scaleY);
+            return true;
+        }
+        return false;
+    }
+}
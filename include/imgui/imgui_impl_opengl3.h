@@ -32,6 +32,12 @@ IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyFontsTexture();
 IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_CreateDeviceObjects();
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyDeviceObjects();
 
+// (Optional) Vertex/index streaming through a persistently mapped ring buffer, on by default when GL 4.4 or GL_ARB_buffer_storage is available.
+// SetBufferStreaming() returns false when the ring isn't supported, rendering then keeps using glBufferData().
+IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_SetBufferStreaming(bool enabled);
+IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_IsBufferStreaming();
+IMGUI_IMPL_API size_t   ImGui_ImplOpenGL3_GetUploadBytes();     // Vertex/index bytes written by the last ImGui_ImplOpenGL3_RenderDrawData() call
+
 // Specific OpenGL ES versions
 //#define IMGUI_IMPL_OPENGL_ES2     // Auto-detected on Emscripten
 //#define IMGUI_IMPL_OPENGL_ES3     // Auto-detected on iOS/Android
@@ -0,0 +1,322 @@
+#pragma once
+
+// imgui [input event queue]
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+
+// varint and float bit coding
+#include "deltacodec.hpp"
+
+// std library
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace inputrecord
+{
+    const char RecordMagic[4] = {'P', 'C', 'I', 'R'};
+    constexpr uint32_t RecordVersion = 2;
+
+    // every frame of a session: delta time, display size and the ImGui input queue as ImGui::NewFrame found it
+    // the queue holds the events the GLFW backend added for the frame after the ones ImGui left over from the previous frame
+    // file: magic, version, scale factor, library hash, imgui.ini text, then one record per frame in frame order
+    // frame: varint field mask, [delta time], [display w, h], [varint event count, events]; floats are zigzag deltas of their ordered bits
+    struct FrameInput
+    {
+        float deltaTime = 0.0f;
+        ImVec2 displaySize;
+        std::vector<ImGuiInputEvent> events;
+    };
+
+    // inner state shared by the writer and the reader, a value is stored as the delta to the previous one of its kind
+    struct FloatDeltas
+    {
+        int64_t deltaTime = 0;
+        int64_t displayW = 0;
+        int64_t displayH = 0;
+        int64_t mouseX = 0;
+        int64_t mouseY = 0;
+    };
+
+    static void WriteFloat(std::string &out, float value, int64_t &previous)
+    {
+        int64_t bits = deltacodec::OrderedFloatBits(value);
+        deltacodec::WriteVarint(out, deltacodec::ZigZagEncode(bits - previous));
+        previous = bits;
+    }
+
+    static bool ReadFloat(const char *&pos, const char *end, float &value, int64_t &previous)
+    {
+        uint64_t delta = 0;
+        if (!deltacodec::ReadVarint(pos, end, delta))
+            return false;
+        previous += deltacodec::ZigZagDecode(delta);
+        value = deltacodec::FromOrderedFloatBits(previous);
+        return true;
+    }
+
+    // frame field mask
+    constexpr uint64_t DeltaTimeChanged = 1;
+    constexpr uint64_t DisplaySizeChanged = 2;
+    constexpr uint64_t HasEvents = 4;
+
+    class Recorder
+    {
+    public:
+        bool Open(const std::string &path, float scaleFactor, uint64_t libraryHash, const char *iniText)
+        {
+            outStream.open(path, std::ios::out | std::ios::binary); // overwrite the file
+            if (!outStream)
+                return false;
+
+            std::string header(RecordMagic, sizeof(RecordMagic));
+            deltacodec::WriteVarint(header, RecordVersion);
+            header.append(reinterpret_cast<const char *>(&scaleFactor), sizeof(scaleFactor));
+            header.append(reinterpret_cast<const char *>(&libraryHash), sizeof(libraryHash));
+            size_t iniSize = iniText != nullptr ? std::strlen(iniText) : 0;
+            deltacodec::WriteVarint(header, iniSize);
+            header.append(iniText != nullptr ? iniText : "", iniSize);
+            outStream.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+            previous = FloatDeltas();
+            lastDeltaTime = -1.0f;
+            lastDisplaySize = ImVec2(-1.0f, -1.0f);
+            frameNum = 0;
+            return static_cast<bool>(outStream);
+        }
+
+        bool IsOpen() const { return outStream.is_open(); }
+        uint64_t FrameNum() const { return frameNum; }
+
+        // call between the backend's NewFrame and ImGui::NewFrame, when the frame's events are queued but not yet processed
+        void CaptureFrame()
+        {
+            if (!outStream.is_open())
+                return;
+
+            const ImGuiContext &g = *ImGui::GetCurrentContext();
+            const ImGuiIO &io = g.IO;
+            uint64_t mask = 0;
+            if (io.DeltaTime != lastDeltaTime)
+                mask |= DeltaTimeChanged;
+            if (io.DisplaySize.x != lastDisplaySize.x || io.DisplaySize.y != lastDisplaySize.y)
+                mask |= DisplaySizeChanged;
+            if (!g.InputEventsQueue.empty())
+                mask |= HasEvents;
+
+            buffer.clear();
+            deltacodec::WriteVarint(buffer, mask);
+            if (mask & DeltaTimeChanged)
+                WriteFloat(buffer, io.DeltaTime, previous.deltaTime);
+            if (mask & DisplaySizeChanged)
+            {
+                WriteFloat(buffer, io.DisplaySize.x, previous.displayW);
+                WriteFloat(buffer, io.DisplaySize.y, previous.displayH);
+            }
+            if (mask & HasEvents)
+            {
+                deltacodec::WriteVarint(buffer, static_cast<uint64_t>(g.InputEventsQueue.Size));
+                for (const ImGuiInputEvent &it : g.InputEventsQueue)
+                    WriteEvent(it);
+            }
+            outStream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+            lastDeltaTime = io.DeltaTime;
+            lastDisplaySize = io.DisplaySize;
+            frameNum++;
+        }
+
+        bool Close()
+        {
+            if (!outStream.is_open())
+                return false;
+            outStream.close();
+            return static_cast<bool>(outStream);
+        }
+
+    private:
+        void WriteEvent(const ImGuiInputEvent &event)
+        {
+            buffer.push_back(static_cast<char>(event.Type));
+            buffer.push_back(static_cast<char>(event.Source));
+            switch (event.Type)
+            {
+            case ImGuiInputEventType_MousePos:
+                WriteFloat(buffer, event.MousePos.PosX, previous.mouseX);
+                WriteFloat(buffer, event.MousePos.PosY, previous.mouseY);
+                break;
+            case ImGuiInputEventType_MouseWheel:
+                buffer.append(reinterpret_cast<const char *>(&event.MouseWheel.WheelX), sizeof(float));
+                buffer.append(reinterpret_cast<const char *>(&event.MouseWheel.WheelY), sizeof(float));
+                break;
+            case ImGuiInputEventType_MouseButton:
+                deltacodec::WriteVarint(buffer, static_cast<uint64_t>(event.MouseButton.Button));
+                buffer.push_back(event.MouseButton.Down ? 1 : 0);
+                break;
+            case ImGuiInputEventType_Key:
+                deltacodec::WriteVarint(buffer, static_cast<uint64_t>(event.Key.Key));
+                buffer.push_back(event.Key.Down ? 1 : 0);
+                buffer.append(reinterpret_cast<const char *>(&event.Key.AnalogValue), sizeof(float));
+                break;
+            case ImGuiInputEventType_Text:
+                deltacodec::WriteVarint(buffer, event.Text.Char);
+                break;
+            case ImGuiInputEventType_Focus:
+                buffer.push_back(event.AppFocused.Focused ? 1 : 0);
+                break;
+            default:
+                break;
+            }
+        }
+
+        std::ofstream outStream;
+        std::string buffer;
+        FloatDeltas previous;
+        float lastDeltaTime = -1.0f;
+        ImVec2 lastDisplaySize = ImVec2(-1.0f, -1.0f);
+        uint64_t frameNum = 0;
+    };
+
+    class Player
+    {
+    public:
+        bool Open(const std::string &path)
+        {
+            std::ifstream inStream;
+            inStream.open(path, std::ios::in | std::ios::binary);
+            if (!inStream)
+                return false;
+            std::stringstream strStream;
+            strStream << inStream.rdbuf();
+            data = strStream.str();
+
+            pos = data.data();
+            const char *end = data.data() + data.size();
+            uint64_t version = 0, iniSize = 0;
+            if (data.size() < sizeof(RecordMagic) || std::memcmp(pos, RecordMagic, sizeof(RecordMagic)) != 0)
+                return false;
+            pos += sizeof(RecordMagic);
+            if (!deltacodec::ReadVarint(pos, end, version) || version != RecordVersion || end - pos < static_cast<ptrdiff_t>(sizeof(float) + sizeof(uint64_t)))
+                return false;
+            std::memcpy(&scaleFactor, pos, sizeof(float));
+            pos += sizeof(float);
+            std::memcpy(&libraryHash, pos, sizeof(uint64_t));
+            pos += sizeof(uint64_t);
+            if (!deltacodec::ReadVarint(pos, end, iniSize) || static_cast<uint64_t>(end - pos) < iniSize)
+                return false;
+            iniText.assign(pos, static_cast<size_t>(iniSize));
+            pos += iniSize;
+
+            previous = FloatDeltas();
+            frame = FrameInput();
+            return true;
+        }
+
+        float ScaleFactor() const { return scaleFactor; }
+        uint64_t LibraryHash() const { return libraryHash; }
+        const std::string &IniText() const { return iniText; }
+
+        // next frame's input, false at the end of the recording or on a damaged frame
+        bool NextFrame(FrameInput *&input)
+        {
+            const char *end = data.data() + data.size();
+            uint64_t mask = 0;
+            if (pos == end || !deltacodec::ReadVarint(pos, end, mask))
+                return false;
+            if ((mask & DeltaTimeChanged) && !ReadFloat(pos, end, frame.deltaTime, previous.deltaTime))
+                return false;
+            if ((mask & DisplaySizeChanged) && (!ReadFloat(pos, end, frame.displaySize.x, previous.displayW) || !ReadFloat(pos, end, frame.displaySize.y, previous.displayH)))
+                return false;
+
+            frame.events.clear();
+            uint64_t eventNum = 0;
+            if ((mask & HasEvents) && !deltacodec::ReadVarint(pos, end, eventNum))
+                return false;
+            for (uint64_t i = 0; i < eventNum; i++)
+            {
+                frame.events.emplace_back();
+                if (!ReadEvent(end, frame.events.back()))
+                    return false;
+            }
+            input = &frame;
+            return true;
+        }
+
+    private:
+        bool ReadEvent(const char *end, ImGuiInputEvent &event)
+        {
+            uint64_t value = 0;
+            if (end - pos < 2)
+                return false;
+            event.Type = static_cast<ImGuiInputEventType>(*pos++);
+            event.Source = static_cast<ImGuiInputSource>(*pos++);
+            switch (event.Type)
+            {
+            case ImGuiInputEventType_MousePos:
+                return ReadFloat(pos, end, event.MousePos.PosX, previous.mouseX) && ReadFloat(pos, end, event.MousePos.PosY, previous.mouseY);
+            case ImGuiInputEventType_MouseWheel:
+                if (end - pos < static_cast<ptrdiff_t>(2 * sizeof(float)))
+                    return false;
+                std::memcpy(&event.MouseWheel.WheelX, pos, sizeof(float));
+                std::memcpy(&event.MouseWheel.WheelY, pos + sizeof(float), sizeof(float));
+                pos += 2 * sizeof(float);
+                return true;
+            case ImGuiInputEventType_MouseButton:
+                if (!deltacodec::ReadVarint(pos, end, value) || pos == end)
+                    return false;
+                event.MouseButton.Button = static_cast<int>(value);
+                event.MouseButton.Down = *pos++ != 0;
+                return true;
+            case ImGuiInputEventType_Key:
+                if (!deltacodec::ReadVarint(pos, end, value) || end - pos < static_cast<ptrdiff_t>(1 + sizeof(float)))
+                    return false;
+                event.Key.Key = static_cast<ImGuiKey>(value);
+                event.Key.Down = *pos++ != 0;
+                std::memcpy(&event.Key.AnalogValue, pos, sizeof(float));
+                pos += sizeof(float);
+                return true;
+            case ImGuiInputEventType_Text:
+                if (!deltacodec::ReadVarint(pos, end, value))
+                    return false;
+                event.Text.Char = static_cast<unsigned int>(value);
+                return true;
+            case ImGuiInputEventType_Focus:
+                if (pos == end)
+                    return false;
+                event.AppFocused.Focused = *pos++ != 0;
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        std::string data;
+        const char *pos = nullptr;
+        float scaleFactor = 1.0f;
+        uint64_t libraryHash = 0;
+        std::string iniText;
+        FloatDeltas previous;
+        FrameInput frame;
+    };
+
+    // set up ImGui's input queue as it was before the recorded frame, call before ImGui::NewFrame with input.deltaTime
+    // the recorded queue already holds the events left over from the previous frame, so it replaces the queue instead of adding to it
+    void QueueFrame(const FrameInput &input)
+    {
+        ImGuiContext &g = *ImGui::GetCurrentContext();
+        g.IO.DisplaySize = input.displaySize;
+        g.InputEventsQueue.resize(0);
+        for (const ImGuiInputEvent &it : input.events)
+            g.InputEventsQueue.push_back(it);
+    }
+
+    // process wide recorder, open only while a session is recorded
+    Recorder &GlobalRecorder()
+    {
+        static Recorder recorder;
+        return recorder;
+    }
+}
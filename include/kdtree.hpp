@@ -0,0 +1,257 @@
+#pragma once
+
+// std library
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace kdtree
+{
+    // ranges up to this size are scanned instead of split
+    constexpr size_t LeafSize = 16;
+
+    // static k-d tree over Dim dimensional points, points and queries must not hold nan
+    // ids are the caller's stable ids and never renumbered, Build numbers its input from 0
+    // inserted points are scanned until the tail grows large, erased points are skipped until the tree is rebuilt
+    template <size_t Dim>
+    class KdTree
+    {
+    public:
+        typedef std::array<float, Dim> Point;
+        typedef std::pair<float, uint32_t> Neighbor; // squared distance, id
+
+        void Build(const std::vector<Point> &input)
+        {
+            points = input;
+            ids.resize(points.size());
+            for (uint32_t i = 0; i < ids.size(); i++)
+                ids[i] = i;
+            slots.assign(points.size(), RemovedId);
+            count = static_cast<uint32_t>(points.size());
+            BuildTree();
+        }
+
+        // id must not be in the tree, the point is scanned from the tail until the next rebuild
+        void Insert(uint32_t id, const Point &point)
+        {
+            if (id >= TailSlot || (id < slots.size() && slots[id] != RemovedId))
+                return;
+
+            if (id >= slots.size())
+                slots.resize(id + 1, RemovedId);
+            slots[id] = TailSlot | static_cast<uint32_t>(tailIds.size());
+            tailPoints.push_back(point);
+            tailIds.push_back(id);
+            count++;
+            if (tailPoints.size() > std::max<size_t>(LeafSize * 16, points.size() / 16))
+                Rebuild();
+        }
+
+        // one lookup, the point is skipped until the next rebuild
+        void Erase(uint32_t id)
+        {
+            if (id >= slots.size() || slots[id] == RemovedId)
+                return;
+
+            uint32_t slot = slots[id];
+            if (slot & TailSlot)
+                tailIds[slot & ~TailSlot] = RemovedId;
+            else
+            {
+                ids[slot] = RemovedId;
+                removedNum++;
+            }
+            slots[id] = RemovedId;
+            count--;
+
+            if (removedNum > points.size() / 4)
+                Rebuild();
+        }
+
+        uint32_t Size() const { return count; }
+
+        // k nearest points by weighted squared distance, nearest first, a zero weight ignores the dimension
+        void KNearest(const Point &query, const Point &weights, size_t k, std::vector<Neighbor> &result) const
+        {
+            result.clear();
+            if (k == 0)
+                return;
+
+            auto consider = [&](const Point &point, uint32_t id) {
+                if (id == RemovedId)
+                    return;
+                float distance = Distance(query, weights, point);
+                if (result.size() < k)
+                {
+                    result.emplace_back(distance, id);
+                    std::push_heap(result.begin(), result.end());
+                }
+                else if (distance < result.front().first)
+                {
+                    std::pop_heap(result.begin(), result.end());
+                    result.back() = Neighbor(distance, id);
+                    std::push_heap(result.begin(), result.end());
+                }
+            };
+
+            for (size_t i = 0; i < tailPoints.size(); i++)
+                consider(tailPoints[i], tailIds[i]);
+            Search(0, points.size(), query, weights, k, consider, result);
+
+            std::sort_heap(result.begin(), result.end());
+        }
+
+    private:
+        static constexpr uint32_t RemovedId = UINT32_MAX;
+        static constexpr uint32_t TailSlot = 1u << 31; // slot flag, the rest is an index into tailIds
+
+        static float Distance(const Point &a, const Point &weights, const Point &b)
+        {
+            float distance = 0.0f;
+            for (size_t d = 0; d < Dim; d++)
+            {
+                if (weights[d] != 0.0f)
+                    distance += weights[d] * (a[d] - b[d]) * (a[d] - b[d]);
+            }
+            return distance;
+        }
+
+        // collect live points back into the tree
+        void Rebuild()
+        {
+            std::vector<Point> livePoints;
+            std::vector<uint32_t> liveIds;
+            livePoints.reserve(count);
+            liveIds.reserve(count);
+            for (size_t i = 0; i < points.size(); i++)
+            {
+                if (ids[i] != RemovedId)
+                {
+                    livePoints.push_back(points[i]);
+                    liveIds.push_back(ids[i]);
+                }
+            }
+            for (size_t i = 0; i < tailPoints.size(); i++)
+            {
+                if (tailIds[i] != RemovedId)
+                {
+                    livePoints.push_back(tailPoints[i]);
+                    liveIds.push_back(tailIds[i]);
+                }
+            }
+            points.swap(livePoints);
+            ids.swap(liveIds);
+            BuildTree();
+        }
+
+        // implicit balanced tree: the node of [begin, end) is its middle element, split on the widest dimension
+        void BuildTree()
+        {
+            tailPoints.clear();
+            tailIds.clear();
+            removedNum = 0;
+            splitDims.assign(points.size(), 0);
+            splitValues.assign(points.size(), 0.0f);
+
+            std::vector<uint32_t> order(points.size());
+            for (uint32_t i = 0; i < order.size(); i++)
+                order[i] = i;
+            Split(order, 0, order.size());
+
+            std::vector<Point> sortedPoints(points.size());
+            std::vector<uint32_t> sortedIds(points.size());
+            for (size_t i = 0; i < order.size(); i++)
+            {
+                sortedPoints[i] = points[order[i]];
+                sortedIds[i] = ids[order[i]];
+            }
+            points.swap(sortedPoints);
+            ids.swap(sortedIds);
+            for (uint32_t i = 0; i < ids.size(); i++)
+                slots[ids[i]] = i;
+        }
+
+        void Split(std::vector<uint32_t> &order, size_t begin, size_t end)
+        {
+            while (end - begin > LeafSize)
+            {
+                // the widest dimension is estimated from a sample, large ranges would cost a full scan per level
+                size_t splitDim = 0;
+                float widest = -1.0f;
+                size_t stride = std::max<size_t>(1, (end - begin) / 256);
+                for (size_t d = 0; d < Dim; d++)
+                {
+                    float low = std::numeric_limits<float>::infinity(), high = -low;
+                    for (size_t i = begin; i < end; i += stride)
+                    {
+                        low = std::min(low, points[order[i]][d]);
+                        high = std::max(high, points[order[i]][d]);
+                    }
+                    if (high - low > widest)
+                    {
+                        widest = high - low;
+                        splitDim = d;
+                    }
+                }
+
+                size_t mid = begin + (end - begin) / 2;
+                std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&](uint32_t a, uint32_t b) {
+                    return points[a][splitDim] < points[b][splitDim];
+                });
+                splitDims[mid] = static_cast<uint8_t>(splitDim);
+                splitValues[mid] = points[order[mid]][splitDim];
+
+                Split(order, begin, mid);
+                begin = mid; // the middle element stays in the right half
+            }
+        }
+
+        template <class Consider>
+        void Search(size_t begin, size_t end, const Point &query, const Point &weights, size_t k, Consider &consider, const std::vector<Neighbor> &result) const
+        {
+            if (end - begin <= LeafSize)
+            {
+                for (size_t i = begin; i < end; i++)
+                    consider(points[i], ids[i]);
+                return;
+            }
+
+            size_t mid = begin + (end - begin) / 2;
+            size_t splitDim = splitDims[mid];
+            float diff = query[splitDim] - splitValues[mid];
+            bool isLeftFirst = diff < 0.0f;
+
+            // near side first, the far side only while it can still hold a closer point
+            if (isLeftFirst)
+                Search(begin, mid, query, weights, k, consider, result);
+            else
+                Search(mid, end, query, weights, k, consider, result);
+
+            if (result.size() < k || weights[splitDim] * diff * diff < result.front().first)
+            {
+                if (isLeftFirst)
+                    Search(mid, end, query, weights, k, consider, result);
+                else
+                    Search(begin, mid, query, weights, k, consider, result);
+            }
+        }
+
+        std::vector<Point> points; // tree order
+        std::vector<uint32_t> ids; // tree order, RemovedId once erased
+        std::vector<uint32_t> slots; // per id: index into ids, TailSlot | index into tailIds, or RemovedId
+        std::vector<uint8_t> splitDims;
+        std::vector<float> splitValues;
+        std::vector<Point> tailPoints; // inserted since the last build
+        std::vector<uint32_t> tailIds;
+        size_t removedNum = 0;
+        uint32_t count = 0;
+    };
+
+    template <size_t Dim>
+    constexpr uint32_t KdTree<Dim>::RemovedId;
+    template <size_t Dim>
+    constexpr uint32_t KdTree<Dim>::TailSlot;
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+// std library
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace logger
+{
+    enum class Severity : uint8_t
+    {
+        Info = 0,
+        Warning = 1,
+        Error = 2
+    };
+
+    constexpr size_t RecordCapacity = 1024;                          // newest records kept, older ones are overwritten
+    constexpr size_t TextWordNum = 32;                               // message bytes per record / 8, longer messages are cut
+    constexpr size_t DedupeTableSize = 1024;                         // distinct messages tracked for repeats, a power of two
+    constexpr int64_t QuietNanoseconds = 10 * 1000000000ll;          // a repeat after this long is logged as new
+    constexpr int ConsoleLinesPerSecond = 10;                        // console writes beyond this are only kept in memory
+
+    // one message, repeats of the same message only bump repeatCount
+    // every field is a relaxed atomic guarded by sequence, readers copy and check it was not rewritten meanwhile
+    struct Record
+    {
+        std::atomic<uint64_t> sequence{0}; // index + 1 once written, BusySequence while being written
+        std::atomic<uint8_t> severity{0};
+        std::atomic<int64_t> firstTime{0}; // nanoseconds since the logger started
+        std::atomic<int64_t> lastTime{0};
+        std::atomic<uint32_t> repeatCount{0};
+        std::atomic<uint64_t> words[TextWordNum];
+    };
+
+    // plain copy of a record for display
+    struct Entry
+    {
+        uint64_t index = 0;
+        Severity severity = Severity::Info;
+        double firstSeconds = 0.0;
+        double lastSeconds = 0.0;
+        uint32_t repeatCount = 0;
+        std::string text;
+    };
+
+    class Logger
+    {
+    public:
+        Logger() : startTime(std::chrono::steady_clock::now())
+        {
+            for (auto &it : records)
+            {
+                for (auto &word : it.words)
+                    word.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        // lock free: a repeat of a recent message costs a hash and a few atomic operations, a new message is copied into the ring
+        void Log(Severity severity, const char *message)
+        {
+            size_t size = std::strlen(message);
+            uint64_t hash = Hash(severity, message, size);
+            int64_t now = Now();
+
+            // a repeat of a message still in the ring only counts up
+            Slot &slot = FindSlot(hash);
+            uint64_t last = slot.recordIndex.load(std::memory_order_acquire);
+            if (slot.hash.load(std::memory_order_relaxed) == hash && last != 0)
+            {
+                Record &record = records[(last - 1) % RecordCapacity];
+                if (record.sequence.load(std::memory_order_acquire) == last &&
+                    now - record.lastTime.load(std::memory_order_relaxed) < QuietNanoseconds)
+                {
+                    record.repeatCount.fetch_add(1, std::memory_order_relaxed);
+                    record.lastTime.store(now, std::memory_order_relaxed);
+                    if (consoleIsUnlimited.load(std::memory_order_relaxed))
+                        WriteConsole(severity, message, now);
+                    return;
+                }
+            }
+
+            uint64_t index = Append(severity, message, size, now);
+            if (&slot != &overflowSlot)
+            {
+                slot.hash.store(hash, std::memory_order_relaxed);
+                slot.recordIndex.store(index + 1, std::memory_order_release);
+            }
+            WriteConsole(severity, message, now);
+        }
+
+        void Log(Severity severity, const std::string &message) { Log(severity, message.c_str()); }
+
+        // index of the next record, records before it are available to Read
+        uint64_t End() const { return head.load(std::memory_order_acquire); }
+
+        // copy of record index, false when it was overwritten or is being written
+        bool Read(uint64_t index, Entry &entry) const
+        {
+            const Record &record = records[index % RecordCapacity];
+            uint64_t sequence = record.sequence.load(std::memory_order_acquire);
+            if (sequence != index + 1)
+                return false;
+
+            char text[TextWordNum * 8 + 1];
+            for (size_t i = 0; i < TextWordNum; i++)
+            {
+                uint64_t word = record.words[i].load(std::memory_order_relaxed);
+                std::memcpy(text + i * 8, &word, 8);
+            }
+            text[TextWordNum * 8] = '\0';
+            entry.index = index;
+            entry.severity = static_cast<Severity>(record.severity.load(std::memory_order_relaxed));
+            entry.firstSeconds = record.firstTime.load(std::memory_order_relaxed) / 1e9;
+            entry.lastSeconds = record.lastTime.load(std::memory_order_relaxed) / 1e9;
+            entry.repeatCount = record.repeatCount.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (record.sequence.load(std::memory_order_relaxed) != sequence)
+                return false;
+            entry.text = text;
+            return true;
+        }
+
+        // console lines dropped by the rate limit so far
+        uint64_t SuppressedNum() const { return suppressedNum.load(std::memory_order_relaxed); }
+
+        // every message and every repeat goes to the console, for command line runs where the console is the only output
+        void SetConsoleUnlimited(bool isUnlimited) { consoleIsUnlimited.store(isUnlimited, std::memory_order_relaxed); }
+
+    private:
+        static constexpr uint64_t BusySequence = UINT64_MAX;
+
+        struct Slot
+        {
+            std::atomic<uint64_t> hash{0};
+            std::atomic<uint64_t> recordIndex{0}; // record index + 1 of the latest copy of the message
+        };
+
+        static uint64_t Hash(Severity severity, const char *message, size_t size)
+        {
+            uint64_t hash = 14695981039346656037ull ^ static_cast<uint8_t>(severity);
+            for (size_t i = 0; i < size; i++)
+            {
+                hash ^= static_cast<uint8_t>(message[i]);
+                hash *= 1099511628211ull;
+            }
+            return hash == 0 ? 1 : hash; // 0 marks a free slot
+        }
+
+        // slot of hash, claimed when free, the overflow slot once the table is full
+        Slot &FindSlot(uint64_t hash)
+        {
+            for (size_t probe = 0; probe < 16; probe++)
+            {
+                Slot &slot = slots[(hash + probe) & (DedupeTableSize - 1)];
+                uint64_t current = slot.hash.load(std::memory_order_relaxed);
+                if (current == hash)
+                    return slot;
+                if (current == 0 && slot.hash.compare_exchange_strong(current, hash, std::memory_order_relaxed))
+                    return slot;
+                if (current == hash) // claimed by another thread logging the same message
+                    return slot;
+            }
+            return overflowSlot; // never matches, every message becomes a new record
+        }
+
+        uint64_t Append(Severity severity, const char *message, size_t size, int64_t now)
+        {
+            uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+            Record &record = records[index % RecordCapacity];
+            record.sequence.store(BusySequence, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release); // a reader seeing the new fields also sees BusySequence
+
+            record.severity.store(static_cast<uint8_t>(severity), std::memory_order_relaxed);
+            record.firstTime.store(now, std::memory_order_relaxed);
+            record.lastTime.store(now, std::memory_order_relaxed);
+            record.repeatCount.store(1, std::memory_order_relaxed);
+            size = std::min(size, TextWordNum * 8);
+            for (size_t i = 0; i < TextWordNum; i++)
+            {
+                uint64_t word = 0;
+                if (i * 8 < size)
+                    std::memcpy(&word, message + i * 8, std::min<size_t>(8, size - i * 8));
+                record.words[i].store(word, std::memory_order_relaxed);
+            }
+
+            record.sequence.store(index + 1, std::memory_order_release);
+            return index;
+        }
+
+        // new messages go to the console too, at most ConsoleLinesPerSecond per second unless it is unlimited
+        // the first line of a second reports how many lines the previous seconds dropped
+        void WriteConsole(Severity severity, const char *message, int64_t now)
+        {
+            static const char *const Prefixes[] = {"", "Warning: ", "Error: "};
+            if (!consoleIsUnlimited.load(std::memory_order_relaxed))
+            {
+                int64_t second = now / 1000000000ll;
+                int64_t windowSecond = consoleSecond.load(std::memory_order_relaxed);
+                if (windowSecond != second && consoleSecond.compare_exchange_strong(windowSecond, second, std::memory_order_relaxed))
+                    consoleLineNum.store(0, std::memory_order_relaxed);
+                if (consoleLineNum.fetch_add(1, std::memory_order_relaxed) >= ConsoleLinesPerSecond)
+                {
+                    suppressedNum.fetch_add(1, std::memory_order_relaxed);
+                    unreportedNum.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                uint64_t droppedNum = unreportedNum.exchange(0, std::memory_order_relaxed);
+                if (droppedNum != 0)
+                    std::cerr << "Warning: " << droppedNum << " log lines not shown, see the Log window\n";
+            }
+
+            (severity == Severity::Info ? std::cout : std::cerr) << Prefixes[static_cast<int>(severity)] << message << '\n';
+        }
+
+        int64_t Now() const
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+        }
+
+        std::chrono::steady_clock::time_point startTime;
+        Record records[RecordCapacity];
+        std::atomic<uint64_t> head{0};
+        Slot slots[DedupeTableSize];
+        Slot overflowSlot;
+        std::atomic<int64_t> consoleSecond{-1};
+        std::atomic<int> consoleLineNum{0};
+        std::atomic<uint64_t> suppressedNum{0};
+        std::atomic<uint64_t> unreportedNum{0}; // suppressed lines not yet reported on the console
+        std::atomic<bool> consoleIsUnlimited{false};
+    };
+
+    // process wide logger, created on first use
+    Logger &GlobalLogger()
+    {
+        static Logger logger;
+        return logger;
+    }
+
+    void Info(const char *message) { GlobalLogger().Log(Severity::Info, message); }
+    void Info(const std::string &message) { GlobalLogger().Log(Severity::Info, message); }
+    void Warning(const char *message) { GlobalLogger().Log(Severity::Warning, message); }
+    void Warning(const std::string &message) { GlobalLogger().Log(Severity::Warning, message); }
+    void Error(const char *message) { GlobalLogger().Log(Severity::Error, message); }
+    void Error(const std::string &message) { GlobalLogger().Log(Severity::Error, message); }
+}
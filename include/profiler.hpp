@@ -0,0 +1,134 @@
+#pragma once
+
+// spans for trace export
+#include "trace.hpp"
+
+// std library
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace profiler
+{
+    constexpr size_t MaxPhaseNum = 16;
+    constexpr size_t SampleNum = 240; // frames kept per phase, 2 to 4 seconds
+
+    // timers only read the clock while this is set, the overlay sets it while it is shown
+    bool IsEnabled = false;
+
+    // per frame time of named phases over the last SampleNum frames, render thread only
+    class FrameProfiler
+    {
+    public:
+        // register a phase once at startup, returns its id
+        int AddPhase(const char *name)
+        {
+            if (phaseNum >= MaxPhaseNum)
+                return -1;
+            names[phaseNum] = name;
+            return static_cast<int>(phaseNum++);
+        }
+
+        // time spent in a phase this frame, a phase entered several times adds up
+        void Add(int phase, float milliseconds)
+        {
+            if (phase >= 0)
+                current[phase] += milliseconds;
+        }
+
+        // commit this frame's phase times to the rolling window
+        void EndFrame()
+        {
+            if (!IsEnabled)
+                return;
+            for (size_t i = 0; i < phaseNum; i++)
+            {
+                samples[i][next] = current[i];
+                current[i] = 0.0f;
+            }
+            next = (next + 1) % SampleNum;
+            filledNum = std::min(filledNum + 1, SampleNum);
+        }
+
+        // drop collected samples, used when the overlay is reopened so stale frames do not count
+        void Reset()
+        {
+            for (size_t i = 0; i < phaseNum; i++)
+                current[i] = 0.0f;
+            next = 0;
+            filledNum = 0;
+        }
+
+        size_t PhaseNum() const { return phaseNum; }
+        const char *Name(int phase) const { return names[phase]; }
+        size_t FilledNum() const { return filledNum; }
+
+        // latest frame of a phase in milliseconds
+        float Last(int phase) const
+        {
+            return filledNum == 0 ? 0.0f : samples[phase][(next + SampleNum - 1) % SampleNum];
+        }
+
+        // percentile in [0, 1] over the filled samples
+        float Percentile(int phase, float percentile) const
+        {
+            if (filledNum == 0)
+                return 0.0f;
+            sortBuf.assign(samples[phase], samples[phase] + filledNum);
+            size_t rank = std::min(filledNum - 1, static_cast<size_t>(percentile * static_cast<float>(filledNum)));
+            std::nth_element(sortBuf.begin(), sortBuf.begin() + rank, sortBuf.end());
+            return sortBuf[rank];
+        }
+
+        // ring of the last SampleNum frames, offset is the oldest one, for ImGui::PlotLines
+        const float *Samples(int phase) const { return samples[phase]; }
+        int Offset() const { return filledNum < SampleNum ? 0 : static_cast<int>(next); }
+
+    private:
+        const char *names[MaxPhaseNum] = {};
+        float current[MaxPhaseNum] = {};
+        float samples[MaxPhaseNum][SampleNum] = {};
+        size_t phaseNum = 0;
+        size_t next = 0;
+        size_t filledNum = 0;
+        mutable std::vector<float> sortBuf;
+    };
+
+    // process wide frame profiler, created on first use
+    FrameProfiler &Frame()
+    {
+        static FrameProfiler frame;
+        return frame;
+    }
+
+    // adds the time of its scope to a phase and records it as a trace span, a couple of branches when both are off
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(int phase) : phase(phase), isTimed(IsEnabled && phase >= 0), isTraced(trace::IsRecording() && phase >= 0)
+        {
+            if (isTimed || isTraced)
+                start = trace::Now();
+        }
+
+        ~ScopedTimer()
+        {
+            if (!isTimed && !isTraced)
+                return;
+            uint64_t end = trace::Now();
+            if (isTimed)
+                Frame().Add(phase, static_cast<float>(end - start) / 1e6f);
+            if (isTraced)
+                trace::CurrentBuffer().Record(Frame().Name(phase), start, end);
+        }
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        int phase;
+        bool isTimed;
+        bool isTraced;
+        uint64_t start = 0;
+    };
+}
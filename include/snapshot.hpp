@@ -0,0 +1,137 @@
+#pragma once
+
+// std library
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace snapshot
+{
+    // records per chunk, a chunk is split once it grows to twice this size
+    constexpr size_t ChunkSize = 1024;
+
+    template <class T>
+    class Publisher;
+
+    // immutable list made of shared chunks, versions share every chunk an edit did not touch
+    template <class T>
+    class ChunkedList
+    {
+    public:
+        size_t Size() const { return offsets.back(); }
+        bool Empty() const { return Size() == 0; }
+        uint64_t Version() const { return version; } // changes on every publish
+
+        const T &operator[](size_t index) const
+        {
+            size_t chunk = static_cast<size_t>(std::upper_bound(offsets.begin(), offsets.end(), index) - offsets.begin()) - 1;
+            return (*chunks[chunk])[index - offsets[chunk]];
+        }
+
+    private:
+        friend class Publisher<T>;
+
+        // chunk holding index, the last chunk for the end position
+        size_t FindChunk(size_t index) const
+        {
+            if (index >= Size())
+                return chunks.size() - 1;
+            return static_cast<size_t>(std::upper_bound(offsets.begin(), offsets.end(), index) - offsets.begin()) - 1;
+        }
+
+        void UpdateOffsets(size_t firstChunk)
+        {
+            offsets.resize(chunks.size() + 1);
+            for (size_t i = firstChunk; i < chunks.size(); i++)
+                offsets[i + 1] = offsets[i] + chunks[i]->size();
+        }
+
+        std::vector<std::shared_ptr<const std::vector<T>>> chunks;
+        std::vector<size_t> offsets = {0}; // chunk i holds [offsets[i], offsets[i + 1])
+        uint64_t version = 0;
+    };
+
+    // single writer publishing versions of a list, readers on any thread take the current one with std::atomic_load
+    // the shared_ptr atomics are not lock-free: libstdc++ guards them with a mutex picked by address,
+    // held only while the pointer is copied, never while a version is read or the next one is built
+    // a version is freed when its last reader drops it
+    template <class T>
+    class Publisher
+    {
+    public:
+        typedef std::shared_ptr<const ChunkedList<T>> Snapshot;
+
+        Publisher() : current(std::make_shared<ChunkedList<T>>()) {}
+
+        Snapshot Load() const { return std::atomic_load(&current); }
+
+        // whole new version, nothing is shared with the previous one
+        void Publish(const std::vector<T> &data)
+        {
+            std::shared_ptr<ChunkedList<T>> next = std::make_shared<ChunkedList<T>>();
+            for (size_t first = 0; first < data.size(); first += ChunkSize)
+            {
+                size_t last = std::min(first + ChunkSize, data.size());
+                next->chunks.push_back(std::make_shared<const std::vector<T>>(data.begin() + first, data.begin() + last));
+            }
+            next->UpdateOffsets(0);
+            Store(std::move(next));
+        }
+
+        // later records move up by one, only the chunk holding index is copied
+        void Insert(size_t index, const T &value)
+        {
+            Snapshot last = Load();
+            if (index > last->Size())
+                return;
+
+            std::shared_ptr<ChunkedList<T>> next = std::make_shared<ChunkedList<T>>(*last);
+            if (next->chunks.empty())
+                next->chunks.push_back(std::make_shared<const std::vector<T>>());
+
+            size_t chunk = next->FindChunk(index);
+            std::vector<T> records(*next->chunks[chunk]);
+            records.insert(records.begin() + (index - next->offsets[chunk]), value);
+            if (records.size() >= ChunkSize * 2)
+            {
+                size_t half = records.size() / 2;
+                next->chunks[chunk] = std::make_shared<const std::vector<T>>(records.begin(), records.begin() + half);
+                next->chunks.insert(next->chunks.begin() + chunk + 1, std::make_shared<const std::vector<T>>(records.begin() + half, records.end()));
+            }
+            else
+                next->chunks[chunk] = std::make_shared<const std::vector<T>>(std::move(records));
+            next->UpdateOffsets(chunk);
+            Store(std::move(next));
+        }
+
+        // later records move down by one, only the chunk holding index is copied
+        void Erase(size_t index)
+        {
+            Snapshot last = Load();
+            if (index >= last->Size())
+                return;
+
+            std::shared_ptr<ChunkedList<T>> next = std::make_shared<ChunkedList<T>>(*last);
+            size_t chunk = next->FindChunk(index);
+            std::vector<T> records(*next->chunks[chunk]);
+            records.erase(records.begin() + (index - next->offsets[chunk]));
+            if (records.empty())
+                next->chunks.erase(next->chunks.begin() + chunk);
+            else
+                next->chunks[chunk] = std::make_shared<const std::vector<T>>(std::move(records));
+            next->UpdateOffsets(chunk);
+            Store(std::move(next));
+        }
+
+    private:
+        void Store(std::shared_ptr<ChunkedList<T>> next)
+        {
+            next->version = ++version;
+            std::atomic_store(&current, Snapshot(std::move(next)));
+        }
+
+        Snapshot current;
+        uint64_t version = 0;
+    };
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+// imgui [plot drawing]
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+
+// std library
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace sweepplot
+{
+    constexpr size_t BaseBucketSize = 16; // points per bucket of the first min/max level, shorter stretches are folded from the points
+    constexpr int MaxSeriesNum = 4;
+
+    // points of a series in sweep order with min/max of every aligned run of BaseBucketSize << level points
+    // a range query folds O(log n) buckets plus up to 2 * BaseBucketSize points
+    class MinMaxPyramid
+    {
+    public:
+        void Clear()
+        {
+            points.clear();
+            levels.clear();
+        }
+
+        void Reserve(size_t pointNum) { points.reserve(pointNum); }
+
+        // level 0 is folded from the new points, every level above from the two buckets below it, so a batch costs O(count + log n)
+        void Append(const float *values, size_t count)
+        {
+            if (count == 0)
+                return;
+            size_t firstBucket = points.size() / BaseBucketSize; // may be partial, folded again
+            points.insert(points.end(), values, values + count);
+            size_t lastBucket = (points.size() - 1) / BaseBucketSize;
+
+            if (levels.empty())
+                levels.emplace_back();
+            levels[0].resize(lastBucket + 1);
+            for (size_t bucket = firstBucket; bucket <= lastBucket; bucket++)
+            {
+                Bucket &it = levels[0][bucket];
+                it.min = FLT_MAX;
+                it.max = -FLT_MAX;
+                Fold(bucket * BaseBucketSize, std::min((bucket + 1) * BaseBucketSize, points.size()), it.min, it.max);
+            }
+
+            for (size_t level = 1; levels[level - 1].size() > 1; level++) // up to a single bucket over every point
+            {
+                if (level == levels.size())
+                    levels.emplace_back();
+                firstBucket >>= 1;
+                lastBucket >>= 1;
+                const std::vector<Bucket> &below = levels[level - 1];
+                levels[level].resize(lastBucket + 1);
+                for (size_t bucket = firstBucket; bucket <= lastBucket; bucket++)
+                {
+                    Bucket it = below[2 * bucket];
+                    if (2 * bucket + 1 < below.size())
+                    {
+                        it.min = std::min(it.min, below[2 * bucket + 1].min);
+                        it.max = std::max(it.max, below[2 * bucket + 1].max);
+                    }
+                    levels[level][bucket] = it;
+                }
+            }
+        }
+
+        size_t Size() const { return points.size(); }
+        float At(size_t index) const { return points[index]; }
+
+        // min and max over points [first, last), false when the range is empty
+        bool Range(size_t first, size_t last, float &min, float &max) const
+        {
+            last = std::min(last, points.size());
+            if (first >= last)
+                return false;
+            min = FLT_MAX;
+            max = -FLT_MAX;
+
+            // unaligned ends come from the points, the aligned middle from the largest buckets that fit
+            size_t bucketFirst = (first + BaseBucketSize - 1) / BaseBucketSize;
+            size_t bucketLast = last / BaseBucketSize;
+            if (bucketFirst >= bucketLast)
+            {
+                Fold(first, last, min, max);
+                return true;
+            }
+            Fold(first, bucketFirst * BaseBucketSize, min, max);
+            Fold(bucketLast * BaseBucketSize, last, min, max);
+            while (bucketFirst < bucketLast)
+            {
+                size_t level = 0;
+                while (level + 1 < levels.size() && bucketFirst % (size_t(2) << level) == 0 && bucketFirst + (size_t(2) << level) <= bucketLast)
+                    level++;
+                const Bucket &bucket = levels[level][bucketFirst >> level];
+                min = std::min(min, bucket.min);
+                max = std::max(max, bucket.max);
+                bucketFirst += size_t(1) << level;
+            }
+            return true;
+        }
+
+    private:
+        struct Bucket
+        {
+            float min;
+            float max;
+        };
+
+        void Fold(size_t first, size_t last, float &min, float &max) const
+        {
+            for (size_t i = first; i < last; i++)
+            {
+                min = std::min(min, points[i]);
+                max = std::max(max, points[i]);
+            }
+        }
+
+        std::vector<float> points;
+        std::vector<std::vector<Bucket>> levels;
+    };
+
+    // points a worker produces, taken over by the UI thread once per frame so the pyramids are only touched there
+    class PointQueue
+    {
+    public:
+        void Push(int series, const float *values, size_t count)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending[series].insert(pending[series].end(), values, values + count);
+        }
+
+        // move the queued points of a series into its pyramid, returns the number moved
+        size_t Drain(int series, MinMaxPyramid &pyramid)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                draining.swap(pending[series]);
+            }
+            size_t count = draining.size();
+            pyramid.Append(draining.data(), count);
+            draining.clear();
+            return count;
+        }
+
+        void Finish() { isFinished.store(true, std::memory_order_release); }
+        bool IsFinished() const { return isFinished.load(std::memory_order_acquire); }
+
+    private:
+        std::mutex mutex;
+        std::vector<float> pending[MaxSeriesNum];
+        std::vector<float> draining; // UI thread only, keeps its capacity between frames
+        std::atomic<bool> isFinished{false};
+    };
+
+    // visible part of the sweep in point indices, the wheel zooms around the mouse and a double click shows everything again
+    struct View
+    {
+        double first = 0.0;
+        double last = 0.0; // 0 shows the whole sweep
+    };
+
+    // inner function
+    static float ToScreenY(float value, float yMin, float yMax, const ImRect &rect)
+    {
+        return rect.Max.y - (value - yMin) / (yMax - yMin) * rect.GetHeight();
+    }
+
+    // line plot of a series laid out over pointNum points at x = xBegin + index * xStep, filled as the sweep progresses
+    // drawing costs one min/max query per pixel column, independent of the number of points
+    // limit, when not nullptr, is drawn as a horizontal red line; returns true while the plot is hovered
+    bool PlotSeries(const char *label, const MinMaxPyramid &series, size_t pointNum, double xBegin, double xStep, View &view, const float *limit, const ImVec2 &size)
+    {
+        ImGuiWindow *window = ImGui::GetCurrentWindow();
+        if (window->SkipItems)
+            return false;
+
+        const ImGuiStyle &style = ImGui::GetStyle();
+        ImVec2 frameSize = ImGui::CalcItemSize(size, ImGui::CalcItemWidth(), ImGui::GetTextLineHeight() * 8 + style.FramePadding.y * 2);
+        ImRect frame(window->DC.CursorPos, ImVec2(window->DC.CursorPos.x + frameSize.x, window->DC.CursorPos.y + frameSize.y));
+        ImRect inner(ImVec2(frame.Min.x + style.FramePadding.x, frame.Min.y + style.FramePadding.y), ImVec2(frame.Max.x - style.FramePadding.x, frame.Max.y - style.FramePadding.y));
+        ImGuiID id = window->GetID(label);
+        ImGui::ItemSize(frame, style.FramePadding.y);
+        if (!ImGui::ItemAdd(frame, id))
+            return false;
+        bool isHovered = ImGui::ItemHoverable(frame, id);
+
+        // zoom with the wheel around the mouse, never closer than one point per pixel
+        if (view.last <= view.first || view.last > static_cast<double>(pointNum))
+        {
+            view.first = 0.0;
+            view.last = static_cast<double>(pointNum);
+        }
+        ImGuiIO &io = ImGui::GetIO();
+        if (isHovered && io.MouseWheel != 0.0f && inner.GetWidth() > 0.0f)
+        {
+            double anchor = view.first + (view.last - view.first) * (io.MousePos.x - inner.Min.x) / inner.GetWidth();
+            double scale = io.MouseWheel > 0.0f ? 0.8 : 1.25;
+            double span = std::max(static_cast<double>(inner.GetWidth()), (view.last - view.first) * scale);
+            span = std::min(span, static_cast<double>(pointNum));
+            view.first = std::max(0.0, std::min(anchor - (anchor - view.first) * span / (view.last - view.first), static_cast<double>(pointNum) - span));
+            view.last = view.first + span;
+        }
+        if (isHovered)
+            ImGui::SetKeyOwner(ImGuiKey_MouseWheelY, id); // from the next frame on the window does not scroll with the plot
+        if (isHovered && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+        {
+            view.first = 0.0;
+            view.last = static_cast<double>(pointNum);
+        }
+
+        ImDrawList *drawList = window->DrawList;
+        drawList->AddRectFilled(frame.Min, frame.Max, ImGui::GetColorU32(ImGuiCol_FrameBg), style.FrameRounding);
+
+        // one column per pixel, the y range follows what is visible
+        int columnNum = std::max(1, static_cast<int>(inner.GetWidth()));
+        double pointsPerColumn = (view.last - view.first) / columnNum;
+        float yMin = FLT_MAX, yMax = -FLT_MAX;
+        if (!series.Range(static_cast<size_t>(view.first), static_cast<size_t>(std::ceil(view.last)), yMin, yMax))
+            yMin = yMax = 0.0f;
+        if (limit != nullptr)
+        {
+            yMin = std::min(yMin, *limit);
+            yMax = std::max(yMax, *limit);
+        }
+        float padding = (yMax - yMin) * 0.05f;
+        if (padding == 0.0f)
+            padding = std::max(1.0f, std::fabs(yMax) * 0.05f);
+        yMin -= padding;
+        yMax += padding;
+
+        ImU32 lineColor = ImGui::GetColorU32(ImGuiCol_PlotLines);
+        drawList->PushClipRect(inner.Min, inner.Max, true);
+        if (pointsPerColumn <= 1.0)
+        {
+            // fewer points than pixels, a polyline through the points themselves
+            size_t first = static_cast<size_t>(view.first);
+            size_t last = std::min(series.Size(), static_cast<size_t>(std::ceil(view.last)) + 1);
+            for (size_t i = first + 1; i < last; i++)
+            {
+                float x0 = inner.Min.x + static_cast<float>((i - 1 - view.first) / pointsPerColumn);
+                float x1 = inner.Min.x + static_cast<float>((i - view.first) / pointsPerColumn);
+                drawList->AddLine(ImVec2(x0, ToScreenY(series.At(i - 1), yMin, yMax, inner)), ImVec2(x1, ToScreenY(series.At(i), yMin, yMax, inner)), lineColor);
+            }
+        }
+        else
+        {
+            // min/max of the points under each column as a vertical stroke, widened to the previous point so the line stays connected
+            for (int column = 0; column < columnNum; column++)
+            {
+                size_t first = static_cast<size_t>(view.first + column * pointsPerColumn);
+                size_t last = static_cast<size_t>(view.first + (column + 1) * pointsPerColumn);
+                float min, max;
+                if (!series.Range(first, last, min, max))
+                    break; // the sweep has not got this far yet
+                if (first > 0)
+                {
+                    min = std::min(min, series.At(first - 1));
+                    max = std::max(max, series.At(first - 1));
+                }
+                float x = inner.Min.x + column + 0.5f;
+                drawList->AddLine(ImVec2(x, ToScreenY(max, yMin, yMax, inner) - 0.5f), ImVec2(x, ToScreenY(min, yMin, yMax, inner) + 0.5f), lineColor);
+            }
+        }
+        if (limit != nullptr)
+        {
+            float y = ToScreenY(*limit, yMin, yMax, inner);
+            drawList->AddLine(ImVec2(inner.Min.x, y), ImVec2(inner.Max.x, y), IM_COL32(255, 80, 80, 255));
+        }
+        drawList->PopClipRect();
+
+        // axis values in the corners
+        char text[64];
+        ImU32 textColor = ImGui::GetColorU32(ImGuiCol_TextDisabled);
+        ImFormatString(text, sizeof(text), "%.6g", yMax);
+        drawList->AddText(inner.Min, textColor, text);
+        ImFormatString(text, sizeof(text), "%.6g", yMin);
+        drawList->AddText(ImVec2(inner.Min.x, inner.Max.y - ImGui::GetTextLineHeight()), textColor, text);
+        ImFormatString(text, sizeof(text), "%.6g .. %.6g", xBegin + view.first * xStep, xBegin + view.last * xStep);
+        drawList->AddText(ImVec2(inner.Max.x - ImGui::CalcTextSize(text).x, inner.Max.y - ImGui::GetTextLineHeight()), textColor, text);
+        drawList->AddText(ImVec2(inner.Max.x - ImGui::CalcTextSize(label, nullptr, true).x, inner.Min.y), ImGui::GetColorU32(ImGuiCol_Text), label, ImGui::FindRenderedTextEnd(label));
+
+        if (isHovered && inner.Contains(io.MousePos))
+        {
+            int column = static_cast<int>(io.MousePos.x - inner.Min.x);
+            size_t first = static_cast<size_t>(view.first + column * pointsPerColumn);
+            size_t last = std::max(first + 1, static_cast<size_t>(view.first + (column + 1) * pointsPerColumn));
+            float min, max;
+            if (series.Range(first, last, min, max))
+            {
+                if (min == max)
+                    ImGui::SetTooltip("%.6g: %.6g", xBegin + first * xStep, min);
+                else
+                    ImGui::SetTooltip("%.6g .. %.6g: %.6g .. %.6g", xBegin + first * xStep, xBegin + (last - 1) * xStep, min, max);
+            }
+        }
+        return isHovered;
+    }
+}
@@ -0,0 +1,280 @@
+#pragma once
+
+// std library
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace threadpool
+{
+    // interactive work runs ahead of normal work, background work only runs when nothing else is queued
+    enum class Priority
+    {
+        High = 0,
+        Normal = 1,
+        Background = 2
+    };
+    constexpr size_t PriorityNum = 3;
+
+    // shared cancel flag, tasks not started when it is set are skipped, running tasks may poll it
+    class CancellationToken
+    {
+    public:
+        CancellationToken() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+        void Cancel() { flag->store(true); }
+        bool IsCancelled() const { return flag->load(); }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> flag;
+    };
+
+    // work stealing pool: one deque per worker, a worker runs its newest task first and steals the oldest task of another worker when idle
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(unsigned threadNum)
+        {
+            threadNum = std::max(1u, threadNum);
+            for (unsigned i = 0; i < threadNum; i++)
+                queues.emplace_back(new WorkerQueue);
+            for (unsigned i = 0; i < threadNum; i++)
+                workers.emplace_back([this, i]() { WorkerLoop(i); });
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                stopping = true;
+            }
+            sleepCondition.notify_all();
+            for (auto &it : workers)
+                it.join();
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        // queue a task, the returned future becomes ready when the task is done or skipped by token
+        std::future<void> Submit(std::function<void()> task, Priority priority = Priority::Normal, CancellationToken token = CancellationToken())
+        {
+            auto packaged = std::make_shared<std::packaged_task<void()>>([task, token]() {
+                if (!token.IsCancelled())
+                    task();
+            });
+            std::future<void> result = packaged->get_future();
+            Push([packaged]() { (*packaged)(); }, priority);
+            return result;
+        }
+
+        // fn(first, last) over [begin, end) in slices of grainSize, returns when every slice is done
+        // the calling thread runs slices too, so it can be used from inside a task
+        // returns false if token skipped some slices, rethrows the first exception of fn
+        template <class Fn>
+        bool ParallelFor(size_t begin, size_t end, size_t grainSize, Fn fn, Priority priority = Priority::High, CancellationToken token = CancellationToken())
+        {
+            if (begin >= end)
+                return !token.IsCancelled();
+            grainSize = std::max<size_t>(1, grainSize);
+
+            size_t sliceNum = (end - begin + grainSize - 1) / grainSize;
+            size_t remaining = sliceNum; // guarded by doneMutex
+            std::mutex doneMutex;
+            std::condition_variable doneCondition;
+            std::atomic<bool> isSkipped(false);
+            std::exception_ptr error;
+            std::mutex errorMutex;
+            auto slices = std::make_shared<SliceQueue>();
+            slices->sliceNum = sliceNum;
+            slices->run = [&](size_t slice) {
+                size_t first = begin + slice * grainSize;
+                if (token.IsCancelled())
+                    isSkipped = true;
+                else
+                {
+                    try
+                    {
+                        fn(first, std::min(first + grainSize, end));
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        if (!error)
+                            error = std::current_exception();
+                    }
+                }
+                // notified under the lock, the caller can not return and destroy doneCondition before notify_all ends
+                std::lock_guard<std::mutex> lock(doneMutex);
+                if (--remaining == 0)
+                    doneCondition.notify_all();
+            };
+
+            // a queued task runs the next slice nobody took yet, a task left over after the last slice does nothing
+            for (size_t i = 1; i < sliceNum; i++)
+                Push([slices]() { slices->RunNext(); }, priority);
+
+            // the caller only takes slices of this call, never other queued work such as a long background task
+            // then block: every slice left has been taken by a thread that runs it to the end
+            while (slices->RunNext())
+                ;
+            {
+                std::unique_lock<std::mutex> lock(doneMutex);
+                doneCondition.wait(lock, [&remaining]() { return remaining == 0; });
+            }
+
+            if (error)
+                std::rethrow_exception(error);
+            return !isSkipped;
+        }
+
+        unsigned Size() const
+        {
+            return static_cast<unsigned>(workers.size());
+        }
+
+    private:
+        // slices of one ParallelFor, shared with its queued tasks which may outlive the call
+        struct SliceQueue
+        {
+            std::atomic<size_t> nextSlice{0};
+            size_t sliceNum = 0;
+            std::function<void(size_t)> run; // only called for a slice below sliceNum, so never after the call returns
+
+            bool RunNext()
+            {
+                size_t slice = nextSlice++;
+                if (slice >= sliceNum)
+                    return false;
+                run(slice);
+                return true;
+            }
+        };
+
+        struct WorkerQueue
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks[PriorityNum];
+        };
+
+        struct WorkerId
+        {
+            const ThreadPool *pool = nullptr;
+            size_t index = 0;
+        };
+
+        static WorkerId &CurrentWorkerId()
+        {
+            static thread_local WorkerId id;
+            return id;
+        }
+
+        // queue index of the calling thread, queues.size() for threads outside this pool
+        size_t CurrentWorker() const
+        {
+            const WorkerId &id = CurrentWorkerId();
+            return id.pool == this ? id.index : queues.size();
+        }
+
+        // a worker queues on its own deque, other threads spread their tasks over all deques
+        void Push(std::function<void()> task, Priority priority)
+        {
+            size_t index = CurrentWorker();
+            if (index == queues.size())
+                index = nextQueue++ % queues.size();
+            pendingNum++; // counted first, a TryPop taking the task right away never takes the count below zero
+            {
+                std::lock_guard<std::mutex> lock(queues[index]->mutex);
+                queues[index]->tasks[static_cast<size_t>(priority)].push_back(std::move(task));
+            }
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex); // a worker between its check and its wait still gets the notify
+            }
+            sleepCondition.notify_one();
+        }
+
+        // highest priority first: own deque from the back, then the front of the other deques
+        bool TryPop(size_t self, std::function<void()> &task)
+        {
+            if (pendingNum.load() == 0)
+                return false;
+
+            for (size_t priority = 0; priority < PriorityNum; priority++)
+            {
+                if (self < queues.size())
+                {
+                    WorkerQueue &queue = *queues[self];
+                    std::lock_guard<std::mutex> lock(queue.mutex);
+                    if (!queue.tasks[priority].empty())
+                    {
+                        task = std::move(queue.tasks[priority].back());
+                        queue.tasks[priority].pop_back();
+                        pendingNum--;
+                        return true;
+                    }
+                }
+                for (size_t i = 1; i <= queues.size(); i++)
+                {
+                    size_t victim = (self + i) % queues.size();
+                    if (victim == self)
+                        continue;
+                    WorkerQueue &queue = *queues[victim];
+                    std::lock_guard<std::mutex> lock(queue.mutex);
+                    if (!queue.tasks[priority].empty())
+                    {
+                        task = std::move(queue.tasks[priority].front());
+                        queue.tasks[priority].pop_front();
+                        pendingNum--;
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        void WorkerLoop(size_t index)
+        {
+            CurrentWorkerId().pool = this;
+            CurrentWorkerId().index = index;
+
+            std::function<void()> task;
+            while (true)
+            {
+                if (TryPop(index, task))
+                {
+                    task();
+                    task = nullptr;
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                sleepCondition.wait(lock, [this]() { return stopping || pendingNum.load() != 0; });
+                if (stopping && pendingNum.load() == 0)
+                    return;
+            }
+        }
+
+        std::vector<std::unique_ptr<WorkerQueue>> queues;
+        std::vector<std::thread> workers;
+        std::atomic<size_t> pendingNum{0}; // queued tasks not yet taken
+        std::atomic<size_t> nextQueue{0};
+        std::mutex sleepMutex;
+        std::condition_variable sleepCondition;
+        bool stopping = false;
+    };
+
+    // process wide pool, one worker per hardware thread, created on first use
+    ThreadPool &GlobalPool()
+    {
+        static ThreadPool pool(std::thread::hardware_concurrency());
+        return pool;
+    }
+}
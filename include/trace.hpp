@@ -0,0 +1,172 @@
+#pragma once
+
+// std library
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace trace
+{
+    constexpr size_t EventCapacity = 1 << 14; // spans kept per thread, older ones are overwritten
+
+    // spans are recorded while this is set, on by default so a stutter can be saved after it happened
+    std::atomic<bool> Recording(true);
+
+    bool IsRecording() { return Recording.load(std::memory_order_relaxed); }
+
+    // nanoseconds on the steady clock
+    uint64_t Now()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // one thread writes its ring, the exporter reads it without stopping the writer
+    // fields are relaxed atomics so a slot being overwritten while read is never undefined, only discarded
+    struct ThreadBuffer
+    {
+        struct Event
+        {
+            std::atomic<const char *> name{nullptr}; // string literal
+            std::atomic<uint64_t> begin{0};
+            std::atomic<uint64_t> duration{0};
+        };
+
+        explicit ThreadBuffer(uint32_t threadId) : threadId(threadId), events(EventCapacity) {}
+
+        void Record(const char *name, uint64_t begin, uint64_t end)
+        {
+            uint64_t index = writeCount.load(std::memory_order_relaxed);
+            Event &event = events[index % EventCapacity];
+            std::atomic_thread_fence(std::memory_order_release); // a reader seeing these stores also sees writeCount == index
+            event.name.store(name, std::memory_order_relaxed);
+            event.begin.store(begin, std::memory_order_relaxed);
+            event.duration.store(end - begin, std::memory_order_relaxed);
+            writeCount.store(index + 1, std::memory_order_release);
+        }
+
+        uint32_t threadId;
+        std::vector<Event> events;
+        std::atomic<uint64_t> writeCount{0};
+    };
+
+    // every thread that recorded a span, kept after the thread exits so its spans can still be exported
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    };
+
+    Registry &GlobalRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    // the calling thread's ring, registered on its first span
+    ThreadBuffer &CurrentBuffer()
+    {
+        static thread_local std::shared_ptr<ThreadBuffer> buffer;
+        if (!buffer)
+        {
+            Registry &registry = GlobalRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            buffer = std::make_shared<ThreadBuffer>(static_cast<uint32_t>(registry.buffers.size()));
+            registry.buffers.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    // records its scope as a span, name must be a string literal
+    class ScopedSpan
+    {
+    public:
+        explicit ScopedSpan(const char *name) : name(IsRecording() ? name : nullptr)
+        {
+            if (this->name != nullptr)
+                begin = Now();
+        }
+
+        ~ScopedSpan()
+        {
+            if (name != nullptr)
+                CurrentBuffer().Record(name, begin, Now());
+        }
+
+        ScopedSpan(const ScopedSpan &) = delete;
+        ScopedSpan &operator=(const ScopedSpan &) = delete;
+
+    private:
+        const char *name;
+        uint64_t begin = 0;
+    };
+
+    // JSON string body, span names are plain literals but keep the output valid anyway
+    void WriteJsonString(std::ofstream &outStream, const char *text)
+    {
+        outStream << '"';
+        for (; *text != '\0'; text++)
+        {
+            if (*text == '"' || *text == '\\')
+                outStream << '\\' << *text;
+            else if (static_cast<unsigned char>(*text) >= 0x20)
+                outStream << *text;
+        }
+        outStream << '"';
+    }
+
+    // Chrome trace event JSON of the spans still in the rings, opens in chrome://tracing and Perfetto
+    bool WriteChromeTrace(const std::string &path)
+    {
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        {
+            Registry &registry = GlobalRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            buffers = registry.buffers;
+        }
+
+        std::ofstream outStream;
+        outStream.open(path, std::ios::out | std::ios::binary); // overwrite the file
+        if (!outStream)
+            return false;
+
+        outStream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool isFirst = true;
+        char number[64];
+        for (auto &buffer : buffers)
+        {
+            outStream << (isFirst ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+                      << ",\"args\":{\"name\":\"thread " << buffer->threadId << "\"}}";
+            isFirst = false;
+
+            uint64_t last = buffer->writeCount.load(std::memory_order_acquire);
+            uint64_t first = last > EventCapacity ? last - EventCapacity : 0;
+            for (uint64_t i = first; i < last; i++)
+            {
+                const ThreadBuffer::Event &event = buffer->events[i % EventCapacity];
+                const char *name = event.name.load(std::memory_order_relaxed);
+                uint64_t begin = event.begin.load(std::memory_order_relaxed);
+                uint64_t duration = event.duration.load(std::memory_order_relaxed);
+
+                // the writer may have wrapped around onto this slot while it was read
+                std::atomic_thread_fence(std::memory_order_acquire);
+                uint64_t written = buffer->writeCount.load(std::memory_order_relaxed);
+                if (name == nullptr || written - i >= EventCapacity)
+                    continue;
+
+                outStream << ",\n{\"name\":";
+                WriteJsonString(outStream, name);
+                std::snprintf(number, sizeof(number), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f", begin / 1000.0, duration / 1000.0);
+                outStream << number << ",\"pid\":1,\"tid\":" << buffer->threadId << '}';
+            }
+        }
+        outStream << "\n]}\n";
+        outStream.close();
+        return static_cast<bool>(outStream);
+    }
+}
@@ -0,0 +1,447 @@
+#pragma once
+
+// std library
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace trigram
+{
+    // results ranked by score, the rest of a large result keeps id order
+    constexpr size_t MaxRankedResults = 1000;
+
+    // near-miss names checked by edit distance, the ones sharing the most trigrams with the query
+    constexpr size_t MaxFuzzyCandidates = 4 * MaxRankedResults;
+
+    // tokens too short to share a trigram with their typo are checked against every name up to this many
+    constexpr size_t MaxFuzzyScanNum = 1 << 16;
+
+    // typos a token may hold and still match, short tokens must match exactly
+    size_t MaxTypoNum(size_t tokenSize)
+    {
+        return tokenSize >= 8 ? 2 : tokenSize >= 4 ? 1 : 0;
+    }
+
+    // lower case ASCII letters, other bytes (UTF-8 included) are kept as they are
+    void Normalize(const std::string &input, std::string &output)
+    {
+        output.resize(input.size());
+        for (size_t i = 0; i < input.size(); i++)
+            output[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(input[i])));
+    }
+
+    // byte trigrams of a normalized string, sorted and unique
+    void Extract(const char *first, const char *last, std::vector<uint32_t> &trigrams)
+    {
+        trigrams.clear();
+        for (; last - first >= 3; first++)
+        {
+            trigrams.push_back(static_cast<uint32_t>(static_cast<unsigned char>(first[0])) << 16 |
+                               static_cast<uint32_t>(static_cast<unsigned char>(first[1])) << 8 |
+                               static_cast<uint32_t>(static_cast<unsigned char>(first[2])));
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    }
+
+    void Extract(const std::string &normalized, std::vector<uint32_t> &trigrams)
+    {
+        Extract(normalized.data(), normalized.data() + normalized.size(), trigrams);
+    }
+
+    // position of token in [first, last), -1 if not found
+    ptrdiff_t Find(const char *first, const char *last, const std::string &token)
+    {
+        if (token.empty())
+            return 0;
+
+        const char *pos = first;
+        while (last - pos >= static_cast<ptrdiff_t>(token.size()))
+        {
+            pos = static_cast<const char *>(std::memchr(pos, token[0], static_cast<size_t>(last - pos) - token.size() + 1));
+            if (pos == nullptr)
+                return -1;
+            if (std::memcmp(pos, token.data(), token.size()) == 0)
+                return pos - first;
+            pos++;
+        }
+        return -1;
+    }
+
+    // fewest edits (insert, delete, replace, swap of neighbors) turning token into some substring of [first, last)
+    // anything over maxDistance is reported as maxDistance + 1
+    size_t SubstringDistance(const char *first, const char *last, const std::string &token, size_t maxDistance)
+    {
+        // column[i] is the distance of token[0, i) to the best substring ending at the current name byte
+        std::vector<size_t> column(token.size() + 1), previous(token.size() + 1), beforePrevious(token.size() + 1);
+        for (size_t i = 0; i <= token.size(); i++)
+            column[i] = i;
+        size_t best = column.back();
+        for (const char *pos = first; pos != last && best > 0; pos++)
+        {
+            beforePrevious.swap(previous);
+            previous.swap(column);
+            column[0] = 0; // a substring may start anywhere
+            for (size_t i = 1; i <= token.size(); i++)
+            {
+                column[i] = std::min(std::min(previous[i], column[i - 1]) + 1, previous[i - 1] + (token[i - 1] == *pos ? 0 : 1));
+                if (i >= 2 && pos > first && token[i - 1] == pos[-1] && token[i - 2] == *pos)
+                    column[i] = std::min(column[i], beforePrevious[i - 2] + 1);
+            }
+            best = std::min(best, column.back());
+        }
+        return std::min(best, maxDistance + 1);
+    }
+
+    // inverted index from trigram to the sorted ids of the names containing it
+    // the index keeps its own packed copy of the normalized names
+    class TrigramIndex
+    {
+    public:
+        void Clear()
+        {
+            postings.clear();
+            nameChars.clear();
+            nameOffsets.assign(1, 0);
+            isErased.clear();
+            version++;
+        }
+
+        // ids are never renumbered, a new name takes an id past every other one so postings stay sorted by appending
+        void Add(uint32_t id, const std::string &name)
+        {
+            if (id < Size())
+                return;
+            while (Size() < id) // ids skipped by the caller hold no name
+            {
+                nameOffsets.push_back(nameOffsets.back());
+                isErased.push_back(1);
+            }
+
+            Normalize(name, normalizedBuf);
+            nameChars += normalizedBuf;
+            nameOffsets.push_back(static_cast<uint32_t>(nameChars.size()));
+            isErased.push_back(0);
+
+            Extract(normalizedBuf, trigramBuf);
+            for (auto it : trigramBuf)
+                postings[it].push_back(id);
+            version++;
+        }
+
+        // the id is not reused, its name stays in nameChars until the next Clear
+        void Erase(uint32_t id)
+        {
+            if (id >= Size() || isErased[id])
+                return;
+
+            Extract(nameChars.data() + nameOffsets[id], nameChars.data() + nameOffsets[id + 1], trigramBuf);
+            for (auto it : trigramBuf)
+            {
+                auto found = postings.find(it);
+                if (found == postings.end())
+                    continue;
+                auto pos = std::lower_bound(found->second.begin(), found->second.end(), id);
+                if (pos != found->second.end() && *pos == id)
+                    found->second.erase(pos);
+                if (found->second.empty())
+                    postings.erase(found);
+            }
+            isErased[id] = 1;
+            version++;
+        }
+
+        uint32_t Size() const { return static_cast<uint32_t>(nameOffsets.size() - 1); } // ids handed out, erased ones included
+        uint64_t Version() const { return version; } // changes on every update
+
+        // ids of the names containing every space separated token of query, best score first
+        // then near-misses: names within MaxTypoNum edits of every token, fewest edits first
+        // typing more characters only filters the previous exact result instead of searching again
+        void Search(const std::string &query, std::vector<uint32_t> &result)
+        {
+            Normalize(query, normalizedBuf);
+            std::vector<std::string> tokens;
+            for (size_t pos = 0; pos < normalizedBuf.size();)
+            {
+                size_t begin = normalizedBuf.find_first_not_of(' ', pos);
+                if (begin == std::string::npos)
+                    break;
+                size_t end = std::min(normalizedBuf.find(' ', begin), normalizedBuf.size());
+                tokens.push_back(normalizedBuf.substr(begin, end - begin));
+                pos = end;
+            }
+
+            result.clear();
+            if (tokens.empty())
+            {
+                lastQuery.clear();
+                return;
+            }
+
+            // candidates: the smallest of the previous result and the trigram posting intersection
+            bool isRefinement = !lastQuery.empty() && lastVersion == version && normalizedBuf.compare(0, lastQuery.size(), lastQuery) == 0;
+            std::vector<uint32_t> candidates;
+            bool hasCandidates = false;
+            if (isRefinement)
+            {
+                candidates.swap(lastIds);
+                hasCandidates = true;
+            }
+
+            std::vector<const std::vector<uint32_t> *> lists;
+            bool hasMissingTrigram = false;
+            for (auto &token : tokens)
+            {
+                Extract(token, trigramBuf);
+                for (auto it : trigramBuf)
+                {
+                    auto found = postings.find(it);
+                    if (found == postings.end())
+                        hasMissingTrigram = true;
+                    else
+                        lists.push_back(&found->second);
+                }
+            }
+
+            if (hasMissingTrigram) // a token can not be contained in any name
+            {
+                candidates.clear();
+                hasCandidates = true;
+            }
+            else if (!lists.empty())
+            {
+                std::sort(lists.begin(), lists.end(), [](const std::vector<uint32_t> *a, const std::vector<uint32_t> *b) { return a->size() < b->size(); });
+                if (!hasCandidates || lists.front()->size() < candidates.size())
+                {
+                    candidates = *lists.front();
+                    hasCandidates = true;
+                }
+                std::vector<uint32_t> intersection;
+                for (auto list : lists) // smallest lists first keep the intersection small
+                {
+                    if (candidates.empty())
+                        break;
+                    intersection.clear();
+                    std::set_intersection(candidates.begin(), candidates.end(), list->begin(), list->end(), std::back_inserter(intersection));
+                    candidates.swap(intersection);
+                }
+            }
+
+            // trigrams only prune, every token must still be a substring of the name
+            size_t tokenChars = 0;
+            for (auto &token : tokens)
+                tokenChars += token.size();
+
+            std::vector<std::pair<float, uint32_t>> scored;
+            auto check = [&](uint32_t id) {
+                const char *first = nameChars.data() + nameOffsets[id];
+                const char *last = nameChars.data() + nameOffsets[id + 1];
+                float score = 0.0f;
+                for (auto &token : tokens)
+                {
+                    ptrdiff_t pos = Find(first, last, token);
+                    if (pos < 0)
+                        return;
+                    if (pos == 0 || !std::isalnum(static_cast<unsigned char>(first[pos - 1])))
+                        score += 0.5f / tokens.size(); // token starts a word
+                }
+                scored.emplace_back(score + Score(first, last, tokens.front(), tokenChars), id);
+            };
+
+            uint32_t count = Size();
+            if (hasCandidates)
+            {
+                for (auto id : candidates)
+                {
+                    if (id < count)
+                        check(id);
+                }
+            }
+            else // only tokens shorter than a trigram, scan every name
+            {
+                for (uint32_t id = 0; id < count; id++)
+                {
+                    if (!isErased[id])
+                        check(id);
+                }
+            }
+
+            // keep the best results in a bounded heap (worst on top), scored is in id order
+            auto better = [&scored](size_t a, size_t b) {
+                return scored[a].first != scored[b].first ? scored[a].first > scored[b].first : scored[a].second < scored[b].second;
+            };
+            std::vector<size_t> ranked;
+            for (size_t i = 0; i < scored.size(); i++)
+            {
+                if (ranked.size() < MaxRankedResults)
+                {
+                    ranked.push_back(i);
+                    std::push_heap(ranked.begin(), ranked.end(), better);
+                }
+                else if (better(i, ranked.front()))
+                {
+                    std::pop_heap(ranked.begin(), ranked.end(), better);
+                    ranked.back() = i;
+                    std::push_heap(ranked.begin(), ranked.end(), better);
+                }
+            }
+            std::sort_heap(ranked.begin(), ranked.end(), better);
+
+            // best results first, the rest keeps id order
+            result.reserve(scored.size());
+            lastIds.clear();
+            lastIds.reserve(scored.size());
+            for (auto i : ranked)
+            {
+                result.push_back(scored[i].second);
+                scored[i].first = -1.0f; // scores are never negative, marks ranked entries
+            }
+            for (auto &it : scored)
+            {
+                lastIds.push_back(it.second);
+                if (it.first >= 0.0f)
+                    result.push_back(it.second);
+            }
+
+            lastQuery = normalizedBuf;
+            lastVersion = version;
+
+            AppendNearMisses(tokens, result);
+        }
+
+    private:
+        // names sharing enough trigrams with the tokens are verified by edit distance, exact matches are already in result
+        void AppendNearMisses(const std::vector<std::string> &tokens, std::vector<uint32_t> &result)
+        {
+            size_t trigramNum = 0, typoNum = 0;
+            hitCounts.resize(Size());
+            for (auto &token : tokens)
+            {
+                Extract(token, trigramBuf);
+                trigramNum += trigramBuf.size();
+                typoNum += MaxTypoNum(token.size());
+                for (auto it : trigramBuf)
+                {
+                    auto found = postings.find(it);
+                    if (found == postings.end())
+                        continue;
+                    for (auto id : found->second)
+                    {
+                        if (hitCounts[id]++ == 0)
+                            hitIds.push_back(id);
+                    }
+                }
+            }
+            if (typoNum == 0) // nothing can match but the exact results
+            {
+                ResetHitCounts();
+                return;
+            }
+
+            // each typo breaks at most three trigrams, too short tokens may share none with the name
+            bool isPruned = trigramNum > 3 * typoNum || Size() > MaxFuzzyScanNum;
+            size_t minHitNum = trigramNum > 3 * typoNum ? trigramNum - 3 * typoNum : isPruned ? 1 : 0;
+            for (auto id : result)
+                hitCounts[id] = UINT32_MAX; // already listed
+            std::vector<std::pair<uint32_t, uint32_t>> candidates; // hit count, id
+            if (isPruned)
+            {
+                for (auto id : hitIds)
+                {
+                    if (hitCounts[id] >= minHitNum && hitCounts[id] != UINT32_MAX)
+                        candidates.emplace_back(hitCounts[id], id);
+                }
+            }
+            else
+            {
+                for (uint32_t id = 0; id < Size(); id++)
+                {
+                    if (hitCounts[id] != UINT32_MAX && !isErased[id])
+                        candidates.emplace_back(hitCounts[id], id);
+                }
+            }
+            for (auto id : result)
+                hitCounts[id] = 0;
+            ResetHitCounts();
+
+            auto moreHits = [](const std::pair<uint32_t, uint32_t> &a, const std::pair<uint32_t, uint32_t> &b) {
+                return a.first != b.first ? a.first > b.first : a.second < b.second;
+            };
+            if (candidates.size() > MaxFuzzyCandidates)
+            {
+                std::nth_element(candidates.begin(), candidates.begin() + MaxFuzzyCandidates, candidates.end(), moreHits);
+                candidates.resize(MaxFuzzyCandidates);
+            }
+            std::sort(candidates.begin(), candidates.end(), moreHits);
+
+            std::vector<std::pair<size_t, uint32_t>> nearMisses; // edits, rank by hit count
+            for (uint32_t rank = 0; rank < candidates.size(); rank++)
+            {
+                uint32_t id = candidates[rank].second;
+                const char *first = nameChars.data() + nameOffsets[id];
+                const char *last = nameChars.data() + nameOffsets[id + 1];
+                size_t editNum = 0;
+                for (auto &token : tokens)
+                {
+                    size_t maxTypoNum = MaxTypoNum(token.size());
+                    size_t distance = SubstringDistance(first, last, token, maxTypoNum);
+                    if (distance > maxTypoNum)
+                    {
+                        editNum = SIZE_MAX;
+                        break;
+                    }
+                    editNum += distance;
+                }
+                if (editNum != SIZE_MAX)
+                    nearMisses.emplace_back(editNum, rank);
+            }
+            std::sort(nearMisses.begin(), nearMisses.end());
+            if (nearMisses.size() > MaxRankedResults)
+                nearMisses.resize(MaxRankedResults);
+            for (auto &it : nearMisses)
+                result.push_back(candidates[it.second].second);
+        }
+
+        void ResetHitCounts()
+        {
+            for (auto id : hitIds)
+                hitCounts[id] = 0;
+            hitIds.clear();
+        }
+
+        // bonuses for exact and prefix matches plus the part of the name covered by the query
+        // linear in the name length, wide queries score every name in the candidates
+        float Score(const char *first, const char *last, const std::string &firstToken, size_t tokenChars) const
+        {
+            float score = 0.0f;
+            size_t nameSize = static_cast<size_t>(last - first);
+            if (nameSize == normalizedBuf.size() && std::memcmp(first, normalizedBuf.data(), nameSize) == 0)
+                score += 2.0f;
+            else if (nameSize >= firstToken.size() && std::memcmp(first, firstToken.data(), firstToken.size()) == 0)
+                score += 1.0f;
+            return score + static_cast<float>(tokenChars) / static_cast<float>(std::max<size_t>(nameSize, 1));
+        }
+
+        std::unordered_map<uint32_t, std::vector<uint32_t>> postings;
+        std::string nameChars;                   // normalized names back to back
+        std::vector<uint32_t> nameOffsets = {0}; // name id spans [nameOffsets[id], nameOffsets[id + 1])
+        std::vector<char> isErased;              // per id, an erased id is in no posting
+        uint64_t version = 0;
+
+        // previous search, reused while the query only grows
+        std::string lastQuery;
+        uint64_t lastVersion = 0;
+        std::vector<uint32_t> lastIds; // previous result in id order
+
+        // scratch buffers
+        std::string normalizedBuf;
+        std::vector<uint32_t> trigramBuf;
+        std::vector<uint32_t> hitCounts; // shared trigrams per id, zero outside a search
+        std::vector<uint32_t> hitIds;    // ids with a nonzero hit count
+    };
+}
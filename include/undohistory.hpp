@@ -0,0 +1,90 @@
+#pragma once
+
+// std library
+#include <cstddef>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace undohistory
+{
+    // bounded undo and redo stacks, an edit only holds what it changed so history never copies the whole document
+    template <class Edit>
+    class UndoHistory
+    {
+    public:
+        explicit UndoHistory(size_t maxDepth) : maxDepth(maxDepth) {}
+
+        // a new edit drops everything that could be redone
+        void Push(Edit edit)
+        {
+            redoEdits.clear();
+            undoEdits.push_back(std::move(edit));
+            if (undoEdits.size() > maxDepth)
+                undoEdits.pop_front();
+        }
+
+        void Clear()
+        {
+            undoEdits.clear();
+            redoEdits.clear();
+        }
+
+        bool CanUndo() const { return !undoEdits.empty(); }
+        bool CanRedo() const { return !redoEdits.empty(); }
+
+        // edit the next Undo or Redo applies, nullptr when there is none
+        const Edit *NextUndo() const { return undoEdits.empty() ? nullptr : &undoEdits.back(); }
+        const Edit *NextRedo() const { return redoEdits.empty() ? nullptr : &redoEdits.back(); }
+
+        // keep(edit) may trim the edit and returns false to drop it, the remaining edits keep their order
+        template <class Keep>
+        void Filter(Keep keep)
+        {
+            FilterStack(undoEdits, keep);
+            FilterStack(redoEdits, keep);
+        }
+
+        // apply(edit, isUndo) reverts or reapplies edit, the edit moves to the other stack only when apply succeeds
+        template <class Apply>
+        bool Undo(Apply apply)
+        {
+            if (undoEdits.empty() || !apply(undoEdits.back(), true))
+                return false;
+            redoEdits.push_back(std::move(undoEdits.back()));
+            undoEdits.pop_back();
+            return true;
+        }
+
+        template <class Apply>
+        bool Redo(Apply apply)
+        {
+            if (redoEdits.empty() || !apply(redoEdits.back(), false))
+                return false;
+            undoEdits.push_back(std::move(redoEdits.back()));
+            redoEdits.pop_back();
+            return true;
+        }
+
+    private:
+        // inner function
+        template <class Stack, class Keep>
+        static void FilterStack(Stack &edits, Keep &keep)
+        {
+            size_t keptNum = 0;
+            for (size_t i = 0; i < edits.size(); i++)
+            {
+                if (!keep(edits[i]))
+                    continue;
+                if (keptNum != i)
+                    edits[keptNum] = std::move(edits[i]);
+                keptNum++;
+            }
+            edits.erase(edits.begin() + static_cast<std::ptrdiff_t>(keptNum), edits.end());
+        }
+
+        std::deque<Edit> undoEdits;
+        std::vector<Edit> redoEdits;
+        size_t maxDepth;
+    };
+}
@@ -2,6 +2,7 @@
 
 // imgui [GUI drawer]
 #include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
 #include "imgui/imgui_stdlib.h"
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
@@ -10,12 +11,38 @@
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
 
+// frame phase timers
+#include "profiler.hpp"
+
+// baked font atlas cache
+#include "fontcache.hpp"
+
+// font lookup warnings
+#include "logger.hpp"
+
+// input event recording
+#include "inputrecord.hpp"
+
+// retained geometry of static panels
+#include "drawcache.hpp"
+
 // std library
+#include <algorithm>
+#include <cctype>
 #include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
 
-// Windows
-#include <windows.h>
+// font directory walk
+#include <dirent.h>
+#include <sys/stat.h>
 
 namespace utility
 {
@@ -23,22 +50,71 @@ namespace utility
 
     const char *GLSL_VERSION = "#version 330";
 
-    const int ScreenBaseResolution = 1920;
     const int WindowBaseWidth = 1280;
     const int WindowBaseHeight = 720;
-    float WindowScaleFactor = 1.5f;
+    const float WindowBaseScale = 1.5f; // UI zoom on a monitor with content scale 1 (96 dpi)
+    float WindowScaleFactor = WindowBaseScale;
+
+    // frame phases timed by the profiler overlay
+    const int PollEventsPhase = profiler::Frame().AddPhase("poll events");
+    const int GUINewFramePhase = profiler::Frame().AddPhase("imgui new frame");
+    const int GUIRenderPhase = profiler::Frame().AddPhase("imgui render");
+    const int OpenGLBackendPhase = profiler::Frame().AddPhase("opengl backend");
+    const int SwapBuffersPhase = profiler::Frame().AddPhase("swap buffers");
+
+    // CJK fonts in order of preference, the first one found in FontDirs is used
+    const char *const FontFileNames[] = {"simhei.ttf", "NotoSansCJKsc-Regular.otf", "NotoSansSC-Regular.otf", "SourceHanSansSC-Regular.otf",
+                                         "NotoSansCJK-Regular.ttc", "wqy-microhei.ttc", "wqy-zenhei.ttc", "DroidSansFallbackFull.ttf"};
+    constexpr int FontDirDepth = 4; // fonts are often a few directories below a font dir
+
+    std::string FontFilePath; // empty when no CJK font was found, ImGui's built in font is used then
+    std::vector<char> FontFileData; // contents of FontFilePath read once, every bake borrows them
+    const float FontSize = 13.0f; // at WindowScaleFactor 1
+    float FontBakedScale = 0.0f;  // WindowScaleFactor the atlas was baked for
+
+    // code points the font atlas is baked with, only characters the UI has shown or is about to show
+    ImFontGlyphRangesBuilder FontGlyphs;
+    ImVector<ImWchar> FontGlyphRanges;
+    bool FontGlyphsChanged = false;
+    double FontBakedTime = 0.0;                 // ImGui::GetTime() of the last bake
+    constexpr double FontCacheWriteDelay = 5.0; // seconds without a new bake before the font cache is written
 
+    // unscaled style, rescaled from this copy whenever WindowScaleFactor changes
+    ImGuiStyle BaseStyle;
+
+    // scale factor from the primary monitor's content scale, glfw must be initialized
     void RescaleWindow()
     {
-        HDC hdc = GetDC(NULL);
-        int windowWidth = GetDeviceCaps(hdc, DESKTOPHORZRES);
-        int windowHeight = GetDeviceCaps(hdc, DESKTOPVERTRES);
-        ReleaseDC(NULL, hdc);
-        std::cout << "window width:" << windowWidth << std::endl;
-        std::cout << "window height:" << windowHeight << std::endl;
+        float xScale = 1.0f, yScale = 1.0f;
+        GLFWmonitor *monitor = glfwGetPrimaryMonitor();
+        if (monitor != NULL)
+            glfwGetMonitorContentScale(monitor, &xScale, &yScale);
+
+        WindowScaleFactor = WindowBaseScale * xScale;
+        std::cout << "window scale factor:" << WindowScaleFactor << std::endl;
+    }
+
+    // inner function, the window moved to a monitor with another content scale, the font is rebaked before the next frame
+    static void WindowContentScaleCallback(GLFWwindow *, float xScale, float)
+    {
+        WindowScaleFactor = WindowBaseScale * xScale;
+    }
 
-        WindowScaleFactor *= static_cast<float>(windowWidth) / static_cast<float>(ScreenBaseResolution);
-        std::cerr << "window scale factor:" << WindowScaleFactor << std::endl;
+    // low power mode: a minimized window draws nothing, an unfocused one draws at a low rate until an event arrives
+    const double UnfocusedTickSeconds = 0.1;
+    const double IconifiedTickSeconds = 0.5; // background work (file watch) still runs this often
+    bool WindowIsIconified = false;
+    bool WindowIsFocused = true;
+
+    // inner function, installed before the imgui backend, which chains to them
+    static void WindowIconifyCallback(GLFWwindow *, int iconified)
+    {
+        WindowIsIconified = iconified == GLFW_TRUE;
+    }
+
+    static void WindowFocusCallback(GLFWwindow *, int focused)
+    {
+        WindowIsFocused = focused == GLFW_TRUE;
     }
 
     // inner function
@@ -46,6 +122,7 @@ namespace utility
     {
         if (!glfwInit())
             return -1;
+        RescaleWindow(); // calculate screen scale factor
 
         glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
         glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -57,6 +134,10 @@ namespace utility
             glfwTerminate();
             return -1;
         }
+        glfwSetWindowContentScaleCallback(window, WindowContentScaleCallback);
+        glfwSetWindowIconifyCallback(window, WindowIconifyCallback);
+        glfwSetWindowFocusCallback(window, WindowFocusCallback);
+        WindowIsFocused = glfwGetWindowAttrib(window, GLFW_FOCUSED) == GLFW_TRUE; // no callback when it starts in the background
         glfwMakeContextCurrent(window);
         glfwSwapInterval(1);
 
@@ -82,17 +163,223 @@ namespace utility
         ImGui::CreateContext();
         ImGui_ImplGlfw_InitForOpenGL(window, true);
         ImGui_ImplOpenGL3_Init(GLSL_VERSION);
-        ImGui::GetStyle().ScaleAllSizes(WindowScaleFactor);
+        BaseStyle = ImGui::GetStyle(); // scaled with the first font bake
+    }
+
+    // inner function, font directories in fontconfig's default order, then the Windows ones
+    static std::vector<std::string> FontDirs()
+    {
+        std::vector<std::string> dirs = {"fonts"}; // in the working directory, for fonts shipped with the program
+        const char *dataHome = std::getenv("XDG_DATA_HOME");
+        const char *home = std::getenv("HOME");
+        if (dataHome != nullptr && *dataHome != '\0')
+            dirs.push_back(std::string(dataHome) + "/fonts");
+        else if (home != nullptr)
+            dirs.push_back(std::string(home) + "/.local/share/fonts");
+        if (home != nullptr)
+            dirs.push_back(std::string(home) + "/.fonts");
+        dirs.push_back("/usr/share/fonts");
+        dirs.push_back("/usr/local/share/fonts");
+
+        const char *windowsDir = std::getenv("WINDIR");
+        const char *localAppData = std::getenv("LOCALAPPDATA");
+        dirs.push_back(std::string(windowsDir != nullptr ? windowsDir : "C:/Windows") + "/Fonts");
+        if (localAppData != nullptr)
+            dirs.push_back(std::string(localAppData) + "/Microsoft/Windows/Fonts");
+        return dirs;
+    }
+
+    // inner function, rank of a font file name in FontFileNames ignoring case, -1 when it is not one of them
+    static int FontFileRank(const char *name)
+    {
+        for (size_t i = 0; i < sizeof(FontFileNames) / sizeof(FontFileNames[0]); i++)
+        {
+            const char *wanted = FontFileNames[i];
+            const char *it = name;
+            while (*it != '\0' && std::tolower(static_cast<unsigned char>(*it)) == std::tolower(static_cast<unsigned char>(*wanted)))
+            {
+                it++;
+                wanted++;
+            }
+            if (*it == '\0' && *wanted == '\0')
+                return static_cast<int>(i);
+        }
+        return -1;
     }
 
-    void GUILoadFont()
+    // inner function, keeps the best ranked font below dir in path
+    static void SearchFontDir(const std::string &dir, int depth, int &bestRank, std::string &path)
+    {
+        DIR *handle = opendir(dir.c_str());
+        if (handle == nullptr)
+            return;
+
+        std::vector<std::string> subDirs;
+        while (dirent *entry = readdir(handle))
+        {
+            if (entry->d_name[0] == '.') // ".", ".." and hidden entries
+                continue;
+            std::string entryPath = dir + "/" + entry->d_name;
+            int rank = FontFileRank(entry->d_name);
+            if (rank >= 0 && (bestRank < 0 || rank < bestRank))
+            {
+                bestRank = rank;
+                path = entryPath;
+            }
+            else if (rank < 0 && depth > 0 && std::strchr(entry->d_name, '.') == nullptr) // font file names have an extension, directories rarely do
+            {
+                struct stat entryStat;
+                if (stat(entryPath.c_str(), &entryStat) == 0 && S_ISDIR(entryStat.st_mode))
+                    subDirs.push_back(entryPath);
+            }
+        }
+        closedir(handle);
+
+        for (auto &it : subDirs)
+        {
+            if (bestRank == 0)
+                return;
+            SearchFontDir(it, depth - 1, bestRank, path);
+        }
+    }
+
+    // best CJK font in the font directories, empty when there is none
+    std::string FindFontFile()
+    {
+        int bestRank = -1;
+        std::string path;
+        for (auto &it : FontDirs())
+        {
+            SearchFontDir(it, FontDirDepth, bestRank, path);
+            if (bestRank == 0)
+                break;
+        }
+        return path;
+    }
+
+    void GUIAddGlyph(unsigned int codepoint)
+    {
+        if (codepoint < 0x80 || codepoint > IM_UNICODE_CODEPOINT_MAX || FontGlyphs.GetBit(codepoint))
+            return;
+        FontGlyphs.SetBit(codepoint);
+        FontGlyphsChanged = true;
+    }
+
+    // add the characters of a UTF-8 text to the atlas, new ones are baked before the next frame
+    void GUIAddGlyphs(const std::string &text)
+    {
+        const char *pos = text.c_str();
+        const char *end = pos + text.size();
+        while (pos < end)
+        {
+            if (static_cast<unsigned char>(*pos) < 0x80) // ascii is always baked
+            {
+                pos++;
+                continue;
+            }
+            unsigned int codepoint = 0;
+            pos += ImTextCharFromUtf8(&codepoint, pos, end);
+            GUIAddGlyph(codepoint);
+        }
+    }
+
+    // uiText: every non ascii character of the UI strings, the atlas starts with these and grows with GUIAddGlyphs
+    void GUILoadFont(const char *uiText)
     {
         ImGuiIO &io = ImGui::GetIO();
-        io.Fonts->AddFontFromFileTTF("C:/Windows/Fonts/simhei.ttf",
-                                     13.0f,
-                                     nullptr,
-                                     io.Fonts->GetGlyphRangesChineseFull());
-        io.FontGlobalScale = WindowScaleFactor;
+        io.Fonts->FontBuilderIO = &fontcache::CachedBuilderIO; // rasterize only when the font, size or ranges changed
+        FontGlyphs.AddRanges(io.Fonts->GetGlyphRangesDefault());
+        GUIAddGlyphs(uiText);
+        FontGlyphsChanged = true;
+
+        FontFilePath = FindFontFile();
+        FontFileData.clear();
+        if (FontFilePath.empty())
+        {
+            logger::Warning("No Chinese font found, install Noto Sans CJK or WenQuanYi, or put simhei.ttf in the fonts directory");
+            return;
+        }
+
+        std::ifstream inStream;
+        inStream.open(FontFilePath, std::ios::in | std::ios::binary);
+        FontFileData.assign(std::istreambuf_iterator<char>(inStream), std::istreambuf_iterator<char>());
+        if (FontFileData.empty())
+        {
+            logger::Warning("Unable to read " + FontFilePath);
+            return;
+        }
+        fontcache::PinFontData(FontFileData.data(), FontFileData.size());
+        std::cout << "font:" << FontFilePath << std::endl;
+    }
+
+    // inner function, characters about to be drawn that no UI string holds: typed text, pasted text and the active text box
+    static void GUIAddPendingGlyphs()
+    {
+        ImGuiContext &g = *ImGui::GetCurrentContext();
+        bool isPasting = false;
+        for (const ImGuiInputEvent &it : g.InputEventsQueue) // typed text shows up in this frame already
+        {
+            if (it.Type == ImGuiInputEventType_Text)
+                GUIAddGlyph(it.Text.Char);
+            else if (it.Type == ImGuiInputEventType_Key && it.Key.Down && (it.Key.Key == ImGuiKey_V || it.Key.Key == ImGuiKey_Insert))
+                isPasting = true; // Ctrl+V or Shift+Insert, the modifiers are only known after NewFrame
+        }
+        if (isPasting)
+        {
+            const char *clipboard = ImGui::GetClipboardText();
+            if (clipboard != nullptr)
+                GUIAddGlyphs(clipboard);
+        }
+
+        // text set by the program or pasted some other way
+        const ImGuiInputTextState &state = g.InputTextState;
+        if (state.ID != 0 && state.ID == g.ActiveId)
+        {
+            for (int i = 0; i < state.CurLenW && i < state.TextW.Size; i++)
+                GUIAddGlyph(state.TextW[i]);
+        }
+    }
+
+    // inner function, rebake the atlas for the current glyph set and scale and upload it again, between frames only
+    // every glyph added since the last frame goes into one bake, the font cache is written once the bakes settle
+    // the font is baked at its pixel size on screen instead of scaled up with FontGlobalScale, so it stays sharp
+    static void GUIUpdateFont()
+    {
+        ImGuiIO &io = ImGui::GetIO();
+        GUIAddPendingGlyphs();
+        if (!FontGlyphsChanged && FontBakedScale == WindowScaleFactor)
+        {
+            if (fontcache::IsCacheDirty && ImGui::GetTime() - FontBakedTime >= FontCacheWriteDelay)
+                fontcache::Flush(io.Fonts);
+            return;
+        }
+        FontGlyphsChanged = false;
+
+        if (FontBakedScale != WindowScaleFactor) // style sizes follow the font
+        {
+            FontBakedScale = WindowScaleFactor;
+            ImGui::GetStyle() = BaseStyle;
+            ImGui::GetStyle().ScaleAllSizes(WindowScaleFactor);
+        }
+
+        bool isUploaded = io.Fonts->TexID != nullptr; // the backend creates the first texture itself
+        io.Fonts->Clear();
+        FontGlyphRanges.clear();
+        FontGlyphs.BuildRanges(&FontGlyphRanges);
+        ImFontConfig config;
+        config.SizePixels = std::round(FontSize * WindowScaleFactor);
+        config.FontDataOwnedByAtlas = false; // FontFileData outlives every bake
+        if (FontFileData.empty() ||
+            io.Fonts->AddFontFromMemoryTTF(FontFileData.data(), static_cast<int>(FontFileData.size()), config.SizePixels, &config, FontGlyphRanges.Data) == nullptr)
+            io.Fonts->AddFontDefault(&config);
+        io.Fonts->Build();
+        FontBakedTime = ImGui::GetTime();
+        drawcache::Invalidate(); // cached text points into the old atlas
+        if (isUploaded)
+        {
+            ImGui_ImplOpenGL3_DestroyFontsTexture();
+            ImGui_ImplOpenGL3_CreateFontsTexture();
+        }
     }
 
     bool WindowShouldClose()
@@ -100,10 +387,15 @@ namespace utility
         return glfwWindowShouldClose(window);
     }
 
-    // inner function
+    // inner function, waits out the low power tick unless an event comes first, so restoring or focusing the window is handled at once
     static void WindowPollEvent()
     {
-        glfwPollEvents();
+        if (WindowIsIconified)
+            glfwWaitEventsTimeout(IconifiedTickSeconds);
+        else if (!WindowIsFocused)
+            glfwWaitEventsTimeout(UnfocusedTickSeconds);
+        else
+            glfwPollEvents();
     }
 
     // inner function
@@ -113,14 +405,20 @@ namespace utility
         glClear(GL_COLOR_BUFFER_BIT);
     }
 
-    void WindowNewFrame()
+    // false while the window is minimized, the caller skips the frame and only does its background work
+    bool WindowNewFrame()
     {
+        profiler::ScopedTimer timer(PollEventsPhase);
         WindowPollEvent();
+        if (WindowIsIconified)
+            return false;
         WindowBackgroundUpdate();
+        return true;
     }
 
     void WindowEndFrame()
     {
+        profiler::ScopedTimer timer(SwapBuffersPhase); // includes the vsync wait
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
         glViewport(0, 0, display_w, display_h);
@@ -129,19 +427,86 @@ namespace utility
 
     void GUINewFrame()
     {
+        profiler::ScopedTimer timer(GUINewFramePhase);
+        GUIUpdateFont();
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
+        inputrecord::GlobalRecorder().CaptureFrame(); // this frame's events, while a session is recorded
         ImGui::NewFrame();
     }
 
     void GUIDrawFrame()
     {
-        ImGui::Render();
+        {
+            profiler::ScopedTimer timer(GUIRenderPhase);
+            ImGui::Render();
+        }
+        profiler::ScopedTimer timer(OpenGLBackendPhase);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
     }
 
+    // create or refill an RGBA texture for ImGui::Image, texels are drawn without filtering; a no op without a window
+    void GUIUpdateTexture(ImTextureID &texture, const uint32_t *pixels, int width, int height)
+    {
+        if (window == nullptr) // headless, nothing is drawn
+            return;
+        GLuint id = static_cast<GLuint>(reinterpret_cast<intptr_t>(texture));
+        if (id == 0)
+        {
+            glGenTextures(1, &id);
+            glBindTexture(GL_TEXTURE_2D, id);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            texture = reinterpret_cast<ImTextureID>(static_cast<intptr_t>(id));
+        }
+        glBindTexture(GL_TEXTURE_2D, id);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+
+    void GUIDestroyTexture(ImTextureID &texture)
+    {
+        GLuint id = static_cast<GLuint>(reinterpret_cast<intptr_t>(texture));
+        if (window != nullptr && id != 0)
+            glDeleteTextures(1, &id);
+        texture = nullptr;
+    }
+
+    // ImGui without a window or renderer for benchmarks, the atlas is only built in memory and draw data is never drawn
+    void HeadlessInit(int width, int height)
+    {
+        ImGui::CreateContext();
+        ImGuiIO &io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(static_cast<float>(width), static_cast<float>(height));
+        io.IniFilename = nullptr; // window layout of the real UI stays untouched
+        BaseStyle = ImGui::GetStyle();
+    }
+
+    void HeadlessNewFrame(float deltaTime)
+    {
+        GUIUpdateFont(); // texture is never uploaded, TexID stays null
+        ImGui::GetIO().DeltaTime = deltaTime;
+        ImGui::NewFrame();
+    }
+
+    ImDrawData *HeadlessEndFrame()
+    {
+        ImGui::Render();
+        return ImGui::GetDrawData();
+    }
+
+    void HeadlessDestroy()
+    {
+        fontcache::Flush(ImGui::GetIO().Fonts);
+        ImGui::DestroyContext();
+    }
+
     void GUIDestroy()
     {
+        fontcache::Flush(ImGui::GetIO().Fonts); // the last bake, unless an earlier write already has it
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
@@ -165,4 +530,70 @@ namespace utility
 
         return integerNum + offset;
     }
+
+    // FNV-1a hash (32 bit), pass the previous result as seed to hash incrementally
+    uint32_t HashFNV1a32(const char *data, size_t size, uint32_t seed = 2166136261u)
+    {
+        uint32_t hash = seed;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    // FNV-1a hash (64 bit), pass the previous result as seed to hash incrementally
+    uint64_t HashFNV1a64(const char *data, size_t size, uint64_t seed = 14695981039346656037ull)
+    {
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // FNV-1a hash (64 bit) of a file's contents, a missing file hashes like an empty one
+    uint64_t HashFileFNV1a64(const std::string &path)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        std::ifstream inStream;
+        inStream.open(path, std::ifstream::in | std::ifstream::binary);
+        std::vector<char> buffer(1 << 20);
+        while (inStream)
+        {
+            inStream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            hash = HashFNV1a64(buffer.data(), static_cast<size_t>(inStream.gcount()), hash);
+        }
+        return hash;
+    }
+
+    // FNV-1a hash (64 bit) of a file's size and its first and last FileEndsHashSize bytes, a missing file hashes like an empty one
+    // cheap enough for every freshness check, an edit of the same size only in the middle of a large file is missed
+    constexpr uint64_t FileEndsHashSize = 1 << 16;
+    uint64_t HashFileEnds(const std::string &path)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        std::ifstream inStream;
+        inStream.open(path, std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+        if (!inStream)
+            return hash;
+
+        uint64_t size = static_cast<uint64_t>(inStream.tellg());
+        hash = HashFNV1a64(reinterpret_cast<const char *>(&size), sizeof(size), hash);
+        std::vector<char> buffer(static_cast<size_t>(std::min(size, FileEndsHashSize)));
+        inStream.seekg(0);
+        inStream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        hash = HashFNV1a64(buffer.data(), static_cast<size_t>(inStream.gcount()), hash);
+        if (size > FileEndsHashSize)
+        {
+            uint64_t tailSize = std::min(size - FileEndsHashSize, FileEndsHashSize);
+            inStream.seekg(static_cast<std::streamoff>(size - tailSize));
+            inStream.read(buffer.data(), static_cast<std::streamsize>(tailSize));
+            hash = HashFNV1a64(buffer.data(), static_cast<size_t>(inStream.gcount()), hash);
+        }
+        return hash;
+    }
 }
@@ -14,6 +14,7 @@
 
 // CHANGELOG
 // (minor and older changes stripped away, please see git history for details)
+//  2023-01-20: OpenGL: Optional streaming of vertex/index data through a persistently mapped, fenced ring buffer on GL 4.4 or GL_ARB_buffer_storage. Added ImGui_ImplOpenGL3_GetUploadBytes().
 //  2022-11-09: OpenGL: Reverted use of glBufferSubData(), too many corruptions issues + old issues seemingly can't be reproed with Intel drivers nowadays (revert 2021-12-15 and 2022-05-23 changes).
 //  2022-10-11: Using 'nullptr' instead of 'NULL' as per our switch to C++11.
 //  2022-09-27: OpenGL: Added ability to '#define IMGUI_IMPL_OPENGL_DEBUG'.
@@ -182,6 +183,38 @@
 #define IMGUI_IMPL_OPENGL_MAY_HAVE_EXTENSIONS
 #endif
 
+// Desktop GL 4.4+ (or GL_ARB_buffer_storage) has glBufferStorage() for persistently mapped buffers.
+// The stripped loader doesn't carry it nor the sync objects, they are fetched with imgl3wGetProcAddress() at init.
+#if !defined(IMGUI_IMPL_OPENGL_ES2) && !defined(IMGUI_IMPL_OPENGL_ES3) && !defined(IMGUI_IMPL_OPENGL_LOADER_CUSTOM) && defined(IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET)
+#define IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT                  0x0002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT             0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT               0x0080
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE     0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT        0x00000001
+#endif
+#ifndef GL_WAIT_FAILED
+#define GL_WAIT_FAILED                    0x911D
+#endif
+typedef void    (APIENTRYP ImGui_ImplOpenGL3_BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void*   (APIENTRYP ImGui_ImplOpenGL3_MapBufferRangeProc)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLsync  (APIENTRYP ImGui_ImplOpenGL3_FenceSyncProc)(GLenum condition, GLbitfield flags);
+typedef GLenum  (APIENTRYP ImGui_ImplOpenGL3_ClientWaitSyncProc)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void    (APIENTRYP ImGui_ImplOpenGL3_DeleteSyncProc)(GLsync sync);
+#endif
+
+// Frames the streaming ring holds. The CPU writes one region while the GPU may still read the other ones.
+#define IMGUI_IMPL_OPENGL_STREAM_REGION_COUNT   3
+
 // [Debugging]
 //#define IMGUI_IMPL_OPENGL_DEBUG
 #ifdef IMGUI_IMPL_OPENGL_DEBUG
@@ -208,6 +241,25 @@ struct ImGui_ImplOpenGL3_Data
     GLsizeiptr      IndexBufferSize;
     bool            HasClipOrigin;
     bool            UseBufferSubData;
+    size_t          UploadBytes;             // Vertex/index bytes written by the last ImGui_ImplOpenGL3_RenderDrawData() call.
+
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    // Streaming ring: IMGUI_IMPL_OPENGL_STREAM_REGION_COUNT regions in one persistently mapped buffer each for vertices and indices, a fence per region.
+    bool            HasBufferStorage;
+    bool            UseStreamBuffer;         // Enabled by default when HasBufferStorage, see ImGui_ImplOpenGL3_SetBufferStreaming().
+    GLuint          StreamVboHandle, StreamElementsHandle;
+    ImDrawVert*     StreamVtxData;           // Whole mapped vertex buffer
+    ImDrawIdx*      StreamIdxData;           // Whole mapped index buffer
+    int             StreamVtxCapacity;       // Vertices per region
+    int             StreamIdxCapacity;       // Indices per region
+    int             StreamRegion;            // Region written by the current frame
+    GLsync          StreamFences[IMGUI_IMPL_OPENGL_STREAM_REGION_COUNT];
+    ImGui_ImplOpenGL3_BufferStorageProc     BufferStorage;
+    ImGui_ImplOpenGL3_MapBufferRangeProc    MapBufferRange;
+    ImGui_ImplOpenGL3_FenceSyncProc         FenceSync;
+    ImGui_ImplOpenGL3_ClientWaitSyncProc    ClientWaitSync;
+    ImGui_ImplOpenGL3_DeleteSyncProc        DeleteSync;
+#endif
 
     ImGui_ImplOpenGL3_Data() { memset((void*)this, 0, sizeof(*this)); }
 };
@@ -324,6 +376,7 @@ bool    ImGui_ImplOpenGL3_Init(const char* glsl_version)
 
     // Detect extensions we support
     bd->HasClipOrigin = (bd->GlVersion >= 450);
+    bool has_buffer_storage = (bd->GlVersion >= 440);
 #ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_EXTENSIONS
     GLint num_extensions = 0;
     glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
@@ -332,9 +385,26 @@ bool    ImGui_ImplOpenGL3_Init(const char* glsl_version)
         const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
         if (extension != nullptr && strcmp(extension, "GL_ARB_clip_control") == 0)
             bd->HasClipOrigin = true;
+        if (extension != nullptr && strcmp(extension, "GL_ARB_buffer_storage") == 0)
+            has_buffer_storage = true;
     }
 #endif
 
+    // Streaming needs glDrawElementsBaseVertex() to draw from an offset into the ring. Sync objects are core since GL 3.2.
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    if (has_buffer_storage && bd->GlVersion >= 320)
+    {
+        bd->BufferStorage = (ImGui_ImplOpenGL3_BufferStorageProc)imgl3wGetProcAddress("glBufferStorage");
+        bd->MapBufferRange = (ImGui_ImplOpenGL3_MapBufferRangeProc)imgl3wGetProcAddress("glMapBufferRange");
+        bd->FenceSync = (ImGui_ImplOpenGL3_FenceSyncProc)imgl3wGetProcAddress("glFenceSync");
+        bd->ClientWaitSync = (ImGui_ImplOpenGL3_ClientWaitSyncProc)imgl3wGetProcAddress("glClientWaitSync");
+        bd->DeleteSync = (ImGui_ImplOpenGL3_DeleteSyncProc)imgl3wGetProcAddress("glDeleteSync");
+        bd->HasBufferStorage = bd->BufferStorage && bd->MapBufferRange && bd->FenceSync && bd->ClientWaitSync && bd->DeleteSync;
+    }
+    bd->UseStreamBuffer = bd->HasBufferStorage;
+#endif
+    (void)has_buffer_storage;
+
     return true;
 }
 
@@ -422,8 +492,18 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
 #endif
 
     // Bind vertex/index buffers and setup attributes for ImDrawVert
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, bd->VboHandle));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bd->ElementsHandle));
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    if (bd->UseStreamBuffer && bd->StreamVtxData != nullptr)
+    {
+        GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, bd->StreamVboHandle));
+        GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bd->StreamElementsHandle));
+    }
+    else
+#endif
+    {
+        GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, bd->VboHandle));
+        GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bd->ElementsHandle));
+    }
     GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxPos));
     GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxUV));
     GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxColor));
@@ -432,6 +512,99 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
     GL_CALL(glVertexAttribPointer(bd->AttribLocationVtxColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)IM_OFFSETOF(ImDrawVert, col)));
 }
 
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+static void ImGui_ImplOpenGL3_WaitStreamRegion(ImGui_ImplOpenGL3_Data* bd, int region)
+{
+    if (bd->StreamFences[region] == nullptr)
+        return;
+    // The GPU is at most IMGUI_IMPL_OPENGL_STREAM_REGION_COUNT - 1 frames behind, so this normally returns at once.
+    // Give up after a second rather than hang on a lost context.
+    bd->ClientWaitSync(bd->StreamFences[region], GL_SYNC_FLUSH_COMMANDS_BIT, (GLuint64)1000000000);
+    bd->DeleteSync(bd->StreamFences[region]);
+    bd->StreamFences[region] = nullptr;
+}
+
+static void ImGui_ImplOpenGL3_DestroyStreamBuffers(ImGui_ImplOpenGL3_Data* bd)
+{
+    for (int region = 0; region < IMGUI_IMPL_OPENGL_STREAM_REGION_COUNT; region++)
+        if (bd->StreamFences[region]) { bd->DeleteSync(bd->StreamFences[region]); bd->StreamFences[region] = nullptr; }
+    if (bd->StreamVboHandle)      { glDeleteBuffers(1, &bd->StreamVboHandle); bd->StreamVboHandle = 0; }        // Deleting a mapped buffer unmaps it
+    if (bd->StreamElementsHandle) { glDeleteBuffers(1, &bd->StreamElementsHandle); bd->StreamElementsHandle = 0; }
+    bd->StreamVtxData = nullptr;
+    bd->StreamIdxData = nullptr;
+    bd->StreamVtxCapacity = bd->StreamIdxCapacity = 0;
+}
+
+// Allocate immutable storage for every region and keep it mapped for the lifetime of the buffers.
+// Only binds GL_ARRAY_BUFFER: GL_ELEMENT_ARRAY_BUFFER is part of the VAO state and the application's VAO is still bound here.
+static bool ImGui_ImplOpenGL3_CreateStreamBuffers(ImGui_ImplOpenGL3_Data* bd, int vtx_capacity, int idx_capacity)
+{
+    ImGui_ImplOpenGL3_DestroyStreamBuffers(bd);
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr vtx_size = (GLsizeiptr)vtx_capacity * IMGUI_IMPL_OPENGL_STREAM_REGION_COUNT * (int)sizeof(ImDrawVert);
+    const GLsizeiptr idx_size = (GLsizeiptr)idx_capacity * IMGUI_IMPL_OPENGL_STREAM_REGION_COUNT * (int)sizeof(ImDrawIdx);
+    glGenBuffers(1, &bd->StreamVboHandle);
+    glGenBuffers(1, &bd->StreamElementsHandle);
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, bd->StreamVboHandle));
+    GL_CALL(bd->BufferStorage(GL_ARRAY_BUFFER, vtx_size, nullptr, flags));
+    bd->StreamVtxData = (ImDrawVert*)bd->MapBufferRange(GL_ARRAY_BUFFER, 0, vtx_size, flags);
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, bd->StreamElementsHandle));
+    GL_CALL(bd->BufferStorage(GL_ARRAY_BUFFER, idx_size, nullptr, flags));
+    bd->StreamIdxData = (ImDrawIdx*)bd->MapBufferRange(GL_ARRAY_BUFFER, 0, idx_size, flags);
+    if (bd->StreamVtxData == nullptr || bd->StreamIdxData == nullptr)
+    {
+        ImGui_ImplOpenGL3_DestroyStreamBuffers(bd);
+        return false;
+    }
+    bd->StreamVtxCapacity = vtx_capacity;
+    bd->StreamIdxCapacity = idx_capacity;
+    bd->StreamRegion = 0;
+    return true;
+}
+
+// Copy every draw list of the frame back to back into the next region of the ring.
+// Returns false when the frame has to go through glBufferData(): streaming is off or the ring couldn't be (re)allocated.
+static bool ImGui_ImplOpenGL3_StreamDrawData(ImGui_ImplOpenGL3_Data* bd, ImDrawData* draw_data, int* vtx_base, int* idx_base)
+{
+    if (!bd->UseStreamBuffer)
+        return false;
+
+    // Grow by half again what this frame needs so a slowly growing UI doesn't reallocate every frame
+    if (draw_data->TotalVtxCount > bd->StreamVtxCapacity || draw_data->TotalIdxCount > bd->StreamIdxCapacity)
+    {
+        int vtx_capacity = draw_data->TotalVtxCount + draw_data->TotalVtxCount / 2;
+        int idx_capacity = draw_data->TotalIdxCount + draw_data->TotalIdxCount / 2;
+        if (vtx_capacity < bd->StreamVtxCapacity) vtx_capacity = bd->StreamVtxCapacity;
+        if (idx_capacity < bd->StreamIdxCapacity) idx_capacity = bd->StreamIdxCapacity;
+        if (vtx_capacity < (1 << 15)) vtx_capacity = 1 << 15;
+        if (idx_capacity < (1 << 16)) idx_capacity = 1 << 16;
+        if (!ImGui_ImplOpenGL3_CreateStreamBuffers(bd, vtx_capacity, idx_capacity))
+        {
+            bd->UseStreamBuffer = false;
+            return false;
+        }
+    }
+
+    bd->StreamRegion = (bd->StreamRegion + 1) % IMGUI_IMPL_OPENGL_STREAM_REGION_COUNT;
+    ImGui_ImplOpenGL3_WaitStreamRegion(bd, bd->StreamRegion);
+    *vtx_base = bd->StreamRegion * bd->StreamVtxCapacity;
+    *idx_base = bd->StreamRegion * bd->StreamIdxCapacity;
+
+    ImDrawVert* vtx_dst = bd->StreamVtxData + *vtx_base;
+    ImDrawIdx* idx_dst = bd->StreamIdxData + *idx_base;
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        memcpy(vtx_dst, cmd_list->VtxBuffer.Data, (size_t)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        memcpy(idx_dst, cmd_list->IdxBuffer.Data, (size_t)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        vtx_dst += cmd_list->VtxBuffer.Size;
+        idx_dst += cmd_list->IdxBuffer.Size;
+    }
+    bd->UploadBytes = (size_t)draw_data->TotalVtxCount * sizeof(ImDrawVert) + (size_t)draw_data->TotalIdxCount * sizeof(ImDrawIdx);
+    return true;
+}
+#endif
+
 // OpenGL3 Render function.
 // Note that this implementation is little overcomplicated because we are saving/setting up/restoring every OpenGL state explicitly.
 // This is in order to be able to run within an OpenGL engine that doesn't do so.
@@ -444,6 +617,7 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
         return;
 
     ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    bd->UploadBytes = 0;
 
     // Backup GL state
     GLenum last_active_texture; glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture);
@@ -484,6 +658,15 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
     GLboolean last_enable_primitive_restart = (bd->GlVersion >= 310) ? glIsEnabled(GL_PRIMITIVE_RESTART) : GL_FALSE;
 #endif
 
+    // Stream the whole frame into the ring before binding anything, so the buffers bound by ImGui_ImplOpenGL3_SetupRenderState() are the final ones.
+    // vtx_base/idx_base are the first vertex/index of the current draw list in the ring, in elements.
+    bool use_stream_buffer = false;
+    int vtx_base = 0;
+    int idx_base = 0;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    use_stream_buffer = ImGui_ImplOpenGL3_StreamDrawData(bd, draw_data, &vtx_base, &idx_base);
+#endif
+
     // Setup desired GL state
     // Recreate the VAO every time (this is to easily allow multiple GL contexts to be rendered to. VAO are not shared among GL contexts)
     // The renderer would actually work without any VAO bound, but then our VertexAttrib calls would overwrite the default one currently bound.
@@ -512,7 +695,11 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
         // - See https://github.com/ocornut/imgui/issues/4468 and please report any corruption issues.
         const GLsizeiptr vtx_buffer_size = (GLsizeiptr)cmd_list->VtxBuffer.Size * (int)sizeof(ImDrawVert);
         const GLsizeiptr idx_buffer_size = (GLsizeiptr)cmd_list->IdxBuffer.Size * (int)sizeof(ImDrawIdx);
-        if (bd->UseBufferSubData)
+        if (use_stream_buffer)
+        {
+            // Already in the ring, see ImGui_ImplOpenGL3_StreamDrawData()
+        }
+        else if (bd->UseBufferSubData)
         {
             if (bd->VertexBufferSize < vtx_buffer_size)
             {
@@ -532,6 +719,8 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
             GL_CALL(glBufferData(GL_ARRAY_BUFFER, vtx_buffer_size, (const GLvoid*)cmd_list->VtxBuffer.Data, GL_STREAM_DRAW));
             GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx_buffer_size, (const GLvoid*)cmd_list->IdxBuffer.Data, GL_STREAM_DRAW));
         }
+        if (!use_stream_buffer)
+            bd->UploadBytes += (size_t)(vtx_buffer_size + idx_buffer_size);
 
         for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
         {
@@ -560,14 +749,25 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
                 GL_CALL(glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->GetTexID()));
 #ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET
                 if (bd->GlVersion >= 320)
-                    GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx)), (GLint)pcmd->VtxOffset));
+                    GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)((idx_base + pcmd->IdxOffset) * sizeof(ImDrawIdx)), (GLint)(vtx_base + pcmd->VtxOffset)));
                 else
 #endif
                 GL_CALL(glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx))));
             }
         }
+        if (use_stream_buffer)
+        {
+            vtx_base += cmd_list->VtxBuffer.Size;
+            idx_base += cmd_list->IdxBuffer.Size;
+        }
     }
 
+    // The region can be written again once the GPU is done with this frame's draws
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    if (use_stream_buffer)
+        bd->StreamFences[bd->StreamRegion] = bd->FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+
     // Destroy the temporary VAO
 #ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
     GL_CALL(glDeleteVertexArrays(1, &vertex_array_object));
@@ -886,9 +1086,44 @@ void    ImGui_ImplOpenGL3_DestroyDeviceObjects()
     if (bd->VboHandle)      { glDeleteBuffers(1, &bd->VboHandle); bd->VboHandle = 0; }
     if (bd->ElementsHandle) { glDeleteBuffers(1, &bd->ElementsHandle); bd->ElementsHandle = 0; }
     if (bd->ShaderHandle)   { glDeleteProgram(bd->ShaderHandle); bd->ShaderHandle = 0; }
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    ImGui_ImplOpenGL3_DestroyStreamBuffers(bd);
+#endif
     ImGui_ImplOpenGL3_DestroyFontsTexture();
 }
 
+size_t  ImGui_ImplOpenGL3_GetUploadBytes()
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    return bd ? bd->UploadBytes : 0;
+}
+
+bool    ImGui_ImplOpenGL3_IsBufferStreaming()
+{
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    return bd && bd->UseStreamBuffer;
+#else
+    return false;
+#endif
+}
+
+bool    ImGui_ImplOpenGL3_SetBufferStreaming(bool enabled)
+{
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    if (bd == nullptr || !bd->HasBufferStorage)
+        return false;
+    bd->UseStreamBuffer = enabled;
+    if (!enabled)
+        ImGui_ImplOpenGL3_DestroyStreamBuffers(bd); // Fences are dropped too, the buffers are freed once the GPU is done with them
+    return true;
+#else
+    (void)enabled;
+    return false;
+#endif
+}
+
 #if defined(__GNUC__)
 #pragma GCC diagnostic pop
 #endif
@@ -1,23 +1,58 @@
 // utility functions and includes(logic independent)
 #include "utility.hpp"
+#include "threadpool.hpp"
+#include "bufferedio.hpp"
+#include "trigram.hpp"
+#include "kdtree.hpp"
+#include "deltacodec.hpp"
+#include "undohistory.hpp"
+#include "snapshot.hpp"
+#include "profiler.hpp"
+#include "logger.hpp"
+#include "sweepplot.hpp"
+#include "heatmap.hpp"
 
 // std library header
-#include <cmath>    // math calculation
-#include <fstream>  // file operation
-#include <sstream>  // string operation
-#include <iostream> // standard input output process
-#include <iomanip>  // input output format control
-#include <vector>   // container
+#include <cmath>         // math calculation
+#include <fstream>       // file operation
+#include <sstream>       // string operation
+#include <iostream>      // standard input output process
+#include <iomanip>       // input output format control
+#include <vector>        // container
+#include <unordered_set> // container
+#include <unordered_map> // container
+#include <algorithm>     // std::equal, std::find
+#include <iterator>      // std::back_inserter
+#include <memory>        // std::unique_ptr
+#include <cstdint>       // fixed width integer
+#include <cstring>       // C string compare
+#include <cctype>        // character classification
+#include <limits>        // float infinity
+#include <sys/stat.h>    // file size and modification time
+#include <chrono>        // bench frame time
+#include <cstdio>        // std::remove
+#include <cstdlib>       // std::atoi, std::atof
+#include <ctime>         // current second for file freshness
+#include <future>        // background library save
 
 // Main Window Function
+int RunWindow(const std::string &recordPath);
 void MainWindowFunction();
 
 // UI layout and UI logic
 void ShowMenuBar();
 void ShowWindows();
 void ShowPorchFileWindow();
+void ShowProfilerWindow();
+void ShowLogWindow();
 void ShowConfirmDeleteWindow();
 void ShowToolTip(const char *message);
+void ShowSimilarConfs(std::string *inputs[]);
+void ShowSweepControls(std::string *inputs[], bool isDSC);
+void ShowSweepWindow();
+void ShowFeasibilityControls(std::string *inputs[], bool isDSC);
+void ShowFeasibilityWindow();
+bool InputTextWithHistory(const char *label, std::string *input, ImGuiInputTextFlags flags);
 void UpdateWindows();
 
 // Add new window
@@ -33,16 +68,154 @@ void DSCCalculateAndShow(int index);
 void NonDSCCalculateAndShow(int index);
 
 // file operation handler
+struct Conf;
 bool SaveToPorchConfFile(bool isDSC, int index, float input[], float output[]);
 bool SaveToPorchConfFile();
 bool LoadPorchConfFile();
+bool LoadPorchConfFileParallel();
+struct PorchIndexEntry;
+bool ParsePorchConfChunk(const std::string &fileBuf, size_t begin, size_t end, std::vector<Conf> &data, std::vector<PorchIndexEntry> &index);
 bool HandlePorchFileHeader(std::string input);
+bool HandlePorchFileHeader(std::string input, std::vector<Conf> &data);
+std::string ParsePorchName(std::istringstream &strStream);
 bool AddPage(bool isDSC, int index, float input[], float output[]);
 bool AddExitsPage();
 bool DeletePage(int index);
+void MarkInMemoryDataLoaded();
+void BuildInMemoryIndexes();
+void EraseInMemoryRecord(uint32_t index);
+void InsertInMemoryRecord(uint32_t index, const Conf &conf);
+std::string GetConfSearchName(const Conf &conf);
+void SaveLibraryAsync();
+bool PollLibrarySave(bool isWait);
 
-// Porch Conf file path
-const std::string PorchConfFilePath = ".\\PorchConf.txt";
+// undo history handler
+struct HistoryEdit;
+bool UndoEdit();
+bool RedoEdit();
+bool ApplyHistoryEdit(HistoryEdit &edit, bool isUndo);
+bool ReloadForLibraryEdit(const HistoryEdit *edit);
+void PushInputEdit(HistoryEdit &edit, std::string *input, const std::string &before);
+std::string *FindCalculatorInput(uint64_t windowId, int field);
+void DropWindowEdits(uint64_t windowId);
+void DropLibraryEdits();
+bool ApplyLibraryEdit(const std::vector<std::pair<uint32_t, Conf>> &erased, const std::vector<std::pair<uint32_t, Conf>> &inserted);
+
+// HFP sweep handler
+struct SweepRun;
+bool ParseCalculatorInputs(std::string *inputs[], bool isDSC, Conf &conf);
+void StartSweep(const Conf &base, float from, float to, size_t pointNum);
+void CancelSweep();
+
+// feasibility map handler
+struct FeasibilityMap;
+void OpenFeasibilityMap(const Conf &base);
+void ResetFeasibilityMap(bool isViewReset);
+void UpdateFeasibilityMap(const ImVec2 &plotSize);
+void CloseFeasibilityMap();
+
+// conf record handler
+void WritePorchConfRecord(std::ostream &outStream, const Conf &conf);
+void WritePorchConfRecord(std::ostream &outStream, const Conf &conf, std::ostringstream &recordStream, uint64_t &offset, std::vector<PorchIndexEntry> &index);
+void RecomputeConf(Conf &conf);
+bool ValidateConf(const Conf &conf, std::string &message);
+int FindConfField(const std::string &name);
+
+// range query handler
+struct RangeQueryTerm;
+bool ParseRangeQuery(const std::string &text, std::vector<RangeQueryTerm> &terms, std::string &message);
+bool MatchRangeQuery(const Conf &conf, const std::vector<RangeQueryTerm> &terms);
+
+// duplicate conf handler
+void CanonicalizeConfPayload(const Conf &conf, float payload[]);
+uint64_t HashConfPayload(const Conf &conf);
+void HashConfPayloads(const std::vector<Conf> &data, std::vector<uint64_t> &hashes);
+bool IsSameConfPayload(const Conf &a, const Conf &b);
+size_t DedupeConfs(std::vector<Conf> &data, std::vector<std::pair<uint32_t, Conf>> *erased = nullptr, std::vector<std::pair<uint32_t, Conf>> *inserted = nullptr);
+bool DedupeInMemoryData();
+
+// archive handler
+bool WriteConfArchive(const std::string &outPath, const std::vector<Conf> &data);
+bool ReadConfArchive(const std::string &inPath, std::vector<Conf> &data);
+void EncodeArchiveBlock(const std::vector<Conf> &data, const uint32_t *order, size_t count, std::string &out);
+bool DecodeArchiveBlock(const char *pos, const char *end, std::vector<std::pair<uint32_t, Conf>> &records);
+
+// CSV/JSON Lines table handler
+enum class ConfTableFormat;
+ConfTableFormat GetConfTableFormat(const std::string &filePath);
+bool ExportConfTable(const std::string &inPath, const std::string &outPath);
+bool ImportConfTable(const std::string &inPath);
+bool ParseCsvLine(const std::string &line, std::vector<std::string> &fields);
+bool IsCsvRecordOpen(const std::string &record);
+bool ParseJsonLine(const std::string &line, std::vector<std::pair<std::string, std::string>> &members);
+void WriteCsvString(bufferedio::BufferedWriter &writer, const std::string &str);
+void WriteJsonString(bufferedio::BufferedWriter &writer, const std::string &str);
+
+// command line handler
+int RunCommandLine(int argc, char *argv[]);
+int RunValidateCommand(const std::string &inPath);
+int RunPipelineCommand(int argc, char *argv[]);
+int RunExportCommand(const std::string &inPath, const std::string &outPath);
+int RunImportCommand(const std::string &inPath, const std::string &outPath);
+int RunQueryCommand(const std::string &inPath, const std::string &query);
+int RunDedupeCommand(const std::string &inPath, const std::string &outPath);
+int RunArchiveCommand(const std::string &inPath, const std::string &outPath);
+int RunExtractCommand(const std::string &inPath, const std::string &outPath);
+int RunBenchCommand(int argc, char *argv[]);
+int RunReplayCommand(int argc, char *argv[]);
+struct BenchFrame;
+int ReportBenchFrames(const std::vector<BenchFrame> &frames, const char *const stageNames[], int stageNum, const std::string &csvPath, double maxMilliseconds);
+bool CopyBenchLibrary(const std::string &inPath);
+void PrintCommandLineUsage();
+
+// sidecar index handler
+bool UpdatePorchIndex();
+bool LoadPorchIndexFile();
+bool SavePorchIndexFile();
+bool ScanPorchConfFile(uint64_t from, uint64_t to);
+void SetPorchIndex(std::vector<PorchIndexEntry> &index);
+uint64_t HashPorchNameWords(const char *first, const char *last);
+bool LoadPorchConfRecord(int index, Conf &conf);
+int FindPorchConfRecord(const std::string &porchName);
+
+// Porch Conf file path, the bench command points it at its own library
+std::string PorchConfFilePath = "PorchConf.txt";
+
+// Porch Conf sidecar index path, holds the byte offset of each "0." record
+std::string PorchIndexFilePath = "PorchConf.idx";
+
+// library and sidecar index the bench command generates, removed when it is done
+const std::string PorchBenchFilePath = "PorchBench.txt";
+const std::string PorchBenchIndexFilePath = "PorchBench.idx";
+const char PorchIndexMagic[4] = {'P', 'C', 'I', 'X'};
+constexpr uint32_t PorchIndexVersion = 2; // 2: hash of the file ends
+
+// Porch Conf archive, blocks of similar records with every column delta encoded
+const char PorchArchiveMagic[4] = {'P', 'C', 'A', 'R'};
+constexpr uint32_t PorchArchiveVersion = 1;
+constexpr size_t ArchiveBlockSize = 4096;
+constexpr uint8_t ArchiveFloatBitsMode = 0xff; // column stored as ordered float bits, other modes are decimal scales
+const double ArchiveDecimalScales[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+
+// CSV/JSON Lines table paths used by the File menu
+const std::string PorchCsvFilePath = "PorchConf.csv";
+const std::string PorchJsonlFilePath = "PorchConf.jsonl";
+
+// Chrome trace event JSON written by Window -> Save Trace
+const std::string PorchTraceFilePath = "PorchTrace.json";
+
+// every non ascii character of the UI strings in this file, the font atlas only bakes these and the ones in porch names
+// regenerate when a UI string gains a new character, a missing one is drawn as '?'
+const char *const UIGlyphText = "。一上下不与且两个中为主之于从代以件任余作例保值像允入全公共其内写出分切列删别到前务化匹区协压参发取变只可台合同名后向否器围固图在坐块域填多如字存完定实寄对将小少屏已帧并序度建开式当得您想或打找拼按据排接推搜撤放数文方时是显曲最有未机条来果查标格模此步段每比求没满照率现用由画留的相码确示称程空端算糊索红线结缩置耗至致若范荐行表要解计议许词该读调超足轴较输辨达过近还这进适通速都配量钟销错际限除随隔需项";
+
+// Porch Conf file header line
+const std::string PorchConfFileHeader = "PorchConfHeader@zionFisher //Do not delete this line or you will not be able to open this file";
+
+// files from this size on are parsed in chunks on the thread pool
+constexpr int64_t ParallelLoadMinFileSize = 1 << 20;
+
+// record sets from this size on are hashed in chunks on the thread pool
+constexpr size_t ParallelHashMinRecordNum = 1 << 12;
 
 // max window number limit
 constexpr int MaxDSCWindowNum = 5;
@@ -56,6 +229,11 @@ static bool NonDSCWindowState[MaxNonDSCWindowNum] = {};
 static std::string DSCWindowName[MaxDSCWindowNum] = {};
 static std::string NonDSCWindowName[MaxNonDSCWindowNum] = {};
 
+// window id, unique over the run so edit history never reaches a later window reusing the slot, 0 when closed
+static uint64_t DSCWindowId[MaxDSCWindowNum] = {};
+static uint64_t NonDSCWindowId[MaxNonDSCWindowNum] = {};
+static uint64_t NextCalculatorWindowId = 1;
+
 // DSC window input buf
 static std::string DSCInputTxvid[MaxDSCWindowNum] = {};
 static std::string DSCInputHactive[MaxDSCWindowNum] = {};
@@ -80,17 +258,39 @@ static std::string NonDSCInputHFP[MaxDSCWindowNum] = {};
 static std::string NonDSCInputHSYNC[MaxDSCWindowNum] = {};
 static std::string NonDSCInputHBP[MaxDSCWindowNum] = {};
 
+// input bufs in ConfFields order
+static std::string *const DSCInputFields[] = {DSCInputTxvid, DSCInputHactive, DSCInputVactive, DSCInputHtotal, DSCInputVtotal,
+                                              DSCInputAdjVactive, DSCInputAdjHactive, DSCInputHFP, DSCInputHSYNC, DSCInputHBP};
+static std::string *const NonDSCInputFields[] = {NonDSCInputTxvid, NonDSCInputHactive, NonDSCInputVactive, NonDSCInputHtotal, NonDSCInputVtotal,
+                                                 NonDSCInputAdjVactive, NonDSCInputAdjHactive, NonDSCInputHFP, NonDSCInputHSYNC, NonDSCInputHBP};
+
+// name of the saved conf holding the same numbers as the last save of each window
+static std::string DSCDuplicateName[MaxDSCWindowNum] = {};
+static std::string NonDSCDuplicateName[MaxNonDSCWindowNum] = {};
+
 // global controller
 bool porchFileIsOpen = false;
+bool profilerIsOpen = false;
+bool logIsOpen = false;
+bool sweepIsOpen = false;
+bool feasibilityIsOpen = false;
 bool confirmDeletePorchIsOpen = false;
 int deletePage = 0;
 
+// frame phases timed by the profiler overlay, the utility:: frame functions time their own
+static const int FramePhase = profiler::Frame().AddPhase("frame");
+static const int LoadConfPhase = profiler::Frame().AddPhase("load conf file");
+static const int MenuBarPhase = profiler::Frame().AddPhase("menu bar");
+static const int CalculatorPhase = profiler::Frame().AddPhase("calculator windows");
+static const int ConfWindowPhase = profiler::Frame().AddPhase("conf window");
+
  // Porch Conf struct
 struct Conf
 {
 public: // Name and type
     std::string porchName = "Default";
     bool isDSC = true;
+    std::vector<std::string> aliases; // names of duplicates merged into this conf
 
 public: // input data
     float txvid = -1;
@@ -114,37 +314,436 @@ public: // output data
     float hblankMinus40 = -2;
 };
 
-// Conf data loaded in memory
+// numeric fields of Conf in file order, shared by the CSV/JSON Lines formats and the batch layout
+struct ConfField
+{
+    const char *name;
+    float Conf::*member;
+};
+
+const ConfField ConfFields[] = {
+    {"txvid", &Conf::txvid},
+    {"hactive", &Conf::hactive},
+    {"vactive", &Conf::vactive},
+    {"htotal", &Conf::htotal},
+    {"vtotal", &Conf::vtotal},
+    {"adj_vactive", &Conf::adjVactive},
+    {"adj_hactive", &Conf::adjHactive},
+    {"HFP", &Conf::HFP},
+    {"HSYNC", &Conf::HSYNC},
+    {"HBP", &Conf::HBP},
+    {"fps", &Conf::fps},
+    {"adj_htotal", &Conf::adjHtotal},
+    {"adj_hblank", &Conf::adjHblank},
+    {"minimum_hline", &Conf::minimumHline},
+    {"minimum_lane_rate", &Conf::minimumLaneRateSwitchToLPMode},
+    {"adj_hblank_minus_40", &Conf::adjHblankMinus40},
+    {"hblank_minus_40", &Conf::hblankMinus40},
+};
+constexpr int ConfFieldNum = sizeof(ConfFields) / sizeof(ConfFields[0]);
+
+// structure of arrays layout of Conf records, columns follow ConfFields
+struct ConfBatch
+{
+    std::vector<std::string> porchName;
+    std::vector<char> isDSC;
+    std::vector<float> columns[ConfFieldNum];
+
+    size_t Size() const { return porchName.size(); }
+
+    void Clear()
+    {
+        porchName.clear();
+        isDSC.clear();
+        for (auto &it : columns)
+            it.clear();
+    }
+
+    void Append(const Conf &conf)
+    {
+        porchName.push_back(conf.porchName);
+        isDSC.push_back(conf.isDSC);
+        for (int i = 0; i < ConfFieldNum; i++)
+            columns[i].push_back(conf.*ConfFields[i].member);
+    }
+
+    Conf Get(size_t index) const
+    {
+        Conf conf;
+        conf.porchName = porchName[index];
+        conf.isDSC = isDSC[index] != 0;
+        for (int i = 0; i < ConfFieldNum; i++)
+            conf.*ConfFields[i].member = columns[i][index];
+        return conf;
+    }
+};
+
+// archive records are sorted by type and then these fields, siblings differing in HFP or vtotal become neighbours
+const char *const ArchiveSortFieldNames[] = {"hactive", "vactive", "adj_hactive", "adj_vactive", "txvid", "HSYNC", "HBP", "htotal", "vtotal", "HFP"};
+
+// one term of a range query: lower <= field <= upper
+struct RangeQueryTerm
+{
+    int field = 0; // index into ConfFields
+    float lower = -std::numeric_limits<float>::infinity();
+    float upper = std::numeric_limits<float>::infinity();
+};
+
+// stable record ids, indexes key records by id so an insert or erase in the middle of the data renumbers no index entry
+class RecordIds
+{
+public:
+    static constexpr uint32_t RemovedPosition = UINT32_MAX;
+
+    void Reset(size_t size);              // record i gets id i
+    uint32_t Insert(uint32_t position);   // id of a record inserted at position
+    uint32_t Erase(uint32_t position);    // id of the erased record, it is never reused
+    uint32_t Position(uint32_t id) const; // data index of id, RemovedPosition once erased
+
+private:
+    std::vector<uint32_t> ids;               // id of each data index
+    mutable std::vector<uint32_t> positions; // data index of each id, refreshed by the first lookup after an edit
+    mutable bool isStale = false;
+};
+
+// ids of InMemoryData records
+static RecordIds InMemoryRecordIds;
+
+// fields with a sorted secondary index
+const char *const RangeIndexFieldNames[] = {"txvid", "hactive", "vactive", "htotal", "vtotal", "adj_vactive", "adj_hactive", "HFP", "fps", "minimum_lane_rate"};
+
+// sorted (value, record id) pairs per indexed field, a query costs O(log N) plus the records in range of its most selective term
+class ConfRangeIndex
+{
+public:
+    void Build(const std::vector<Conf> &data); // record i gets id i
+    void Insert(uint32_t id, const Conf &conf);
+    void Erase(uint32_t id, const Conf &conf);
+    // result holds data indices, in value order of the most selective term, or file order when no term is indexed
+    void Query(const std::vector<Conf> &data, const RecordIds &recordIds, const std::vector<RangeQueryTerm> &terms, std::vector<uint32_t> &result) const;
+    uint64_t Version() const { return version; } // changes on every update
+
+private:
+    typedef std::pair<float, uint32_t> Entry;
+    std::vector<Entry> entries[ConfFieldNum];
+    bool isIndexed[ConfFieldNum] = {};
+    uint64_t version = 0;
+};
+
+// range index over InMemoryData
+static ConfRangeIndex InMemoryRangeIndex;
+
+// trigram index over InMemoryData porch names
+static trigram::TrigramIndex InMemoryNameIndex;
+
+// input fields compared by "find similar", each scaled by its spread over the library
+const char *const SimilarFieldNames[] = {"txvid", "hactive", "vactive", "htotal", "vtotal", "HFP", "HSYNC", "HBP"};
+constexpr size_t SimilarFieldNum = sizeof(SimilarFieldNames) / sizeof(SimilarFieldNames[0]);
+constexpr size_t SimilarConfNum = 5;
+
+// k-d tree over the normalized SimilarFieldNames inputs, top-k queries visit O(log N) records on average
+class ConfSimilarIndex
+{
+public:
+    typedef kdtree::KdTree<SimilarFieldNum>::Neighbor Neighbor; // squared normalized distance, data index
+
+    void Build(const std::vector<Conf> &data); // record i gets id i
+    void Insert(uint32_t id, const Conf &conf);
+    void Erase(uint32_t id);
+    void Query(const Conf &conf, const RecordIds &recordIds, size_t k, std::vector<Neighbor> &result) const; // nan fields of conf are ignored
+    uint64_t Version() const { return version; } // changes on every update
+
+private:
+    kdtree::KdTree<SimilarFieldNum>::Point ToPoint(const Conf &conf) const;
+
+    int fields[SimilarFieldNum] = {}; // indices into ConfFields
+    float scales[SimilarFieldNum] = {};
+    kdtree::KdTree<SimilarFieldNum> tree;
+    uint64_t version = 0;
+};
+
+// similar timing index over InMemoryData
+static ConfSimilarIndex InMemorySimilarIndex;
+
+// record ids by payload hash, finds confs holding the same numbers under another name
+class ConfPayloadIndex
+{
+public:
+    void Build(const std::vector<Conf> &data); // hashed on the thread pool, record i gets id i
+    void Insert(uint32_t id, const Conf &conf);
+    void Erase(uint32_t id, const Conf &conf);
+    int Find(const std::vector<Conf> &data, const RecordIds &recordIds, const Conf &conf) const; // data index of a record with the same payload, -1 if none
+
+private:
+    std::unordered_map<uint64_t, std::vector<uint32_t>> ids;
+};
+
+// payload index over InMemoryData
+static ConfPayloadIndex InMemoryPayloadIndex;
+
+// calculator input text around one edit, the input is found again by window id and ConfFields index
+struct InputEdit
+{
+    uint64_t windowId;
+    int field;
+    std::string before;
+    std::string after;
+};
+
+// one undoable change, only the records and inputs it touched are stored
+struct HistoryEdit
+{
+    std::vector<std::pair<uint32_t, Conf>> erased;   // record indices before the edit, ascending
+    std::vector<std::pair<uint32_t, Conf>> inserted; // record indices after the edit, ascending
+    std::vector<InputEdit> inputs;
+};
+
+// edits of InMemoryData and the calculator inputs
+// a reload of InMemoryData drops the library edits, input edits are dropped when their window closes
+constexpr size_t MaxHistoryDepth = 100;
+static undohistory::UndoHistory<HistoryEdit> EditHistory(MaxHistoryDepth);
+static uint64_t InMemoryDataLoadNum = 0; // reloads of InMemoryData from the file
+
+// background rewrite of the Porch Conf file after an undo or redo, InMemoryData is ahead of the file until it ends
+struct LibrarySave
+{
+    std::future<void> write;
+    std::shared_ptr<bool> isWritten; // set by the worker, read after write is ready
+    std::shared_ptr<std::vector<PorchIndexEntry>> index; // sidecar index of the written bytes, filled by the worker
+    bool isQueued = false;           // InMemoryData changed again while writing, the newest version is written next
+};
+static LibrarySave PendingLibrarySave;
+
+// library edits touching more records than this rebuild the indexes instead of updating them per record
+constexpr size_t IncrementalEditMaxRecordNum = 64;
+
+// HFP sweep of a calculator window's inputs, computed on a background worker and drained into the plots every frame
+struct SweepRun
+{
+    Conf base;
+    double from = 0.0;
+    double step = 0.0;
+    size_t pointNum = 0;
+    threadpool::CancellationToken token;
+    std::shared_ptr<sweepplot::PointQueue> queue; // shared with the worker, a cancelled one may still be writing
+    sweepplot::MinMaxPyramid fps;
+    sweepplot::MinMaxPyramid laneRate;
+    sweepplot::View view; // both plots show the same range
+};
+static SweepRun HfpSweep;
+constexpr int SweepFpsSeries = 0;
+constexpr int SweepLaneRateSeries = 1;
+constexpr size_t SweepBatchSize = 1 << 16;        // points per push to the UI
+constexpr size_t MaxSweepPointNum = 10000000;
+static float PhyLaneRateLimit = 2500.0f;          // Mbps per lane, drawn over the lane rate curve
+
+// two inputs of a calculator window mapped over a grid, each cell classed by fps range and lane rate limit
+// tiles are refined on background workers and cached across pans and zooms, the visible cells are uploaded as a texture
+struct FeasibilityMap
+{
+    Conf base;
+    int xField = 7; // HFP
+    int yField = 4; // vtotal
+    float fpsRange[2] = {59.5f, 60.5f}; // min, max
+    float laneRateLimit = 0.0f; // PhyLaneRateLimit the cached tiles were computed with
+    heatmap::View view;
+    heatmap::View home;
+    heatmap::TileCache cache;
+    std::unordered_set<heatmap::TileKey, heatmap::TileKeyHash> pending; // submitted, not drained yet
+    std::shared_ptr<heatmap::TileQueue> queue; // replaced on reset, tiles of old inputs go to the old one
+    threadpool::CancellationToken token;
+    std::vector<heatmap::Tile> drained;
+    size_t evaluatedNum = 0;
+    uint64_t frame = 0;
+    ImTextureID texture = nullptr;
+    heatmap::View image; // input values the texture covers
+    heatmap::TileKey imageKey; // levels and first cell of the texture
+    int imageWidth = 0;
+    int imageHeight = 0;
+    bool isImageDirty = true;
+    std::vector<uint8_t> cells;
+    std::vector<uint32_t> pixels;
+};
+static FeasibilityMap Feasibility;
+constexpr uint8_t Feasible = 0;        // cell classes, fps out of range and lane rate over limit are bits
+constexpr uint8_t FpsOutOfRange = 1;
+constexpr uint8_t LaneRateOverLimit = 2;
+constexpr uint8_t InvalidInput = 4;
+const ImU32 FeasibilityColors[] = {IM_COL32(70, 170, 90, 255), IM_COL32(80, 110, 190, 255), IM_COL32(220, 140, 50, 255), IM_COL32(190, 60, 60, 255), IM_COL32(60, 60, 60, 255)};
+const char *const FeasibilityNames[] = {"feasible", "fps out of range", "lane rate over limit", "both", "invalid input"};
+constexpr int FeasibilityCellPixels = 2;      // screen pixels per cell at most
+constexpr int FeasibilityCoarseLevelNum = 3;  // levels above the visible one computed first, shown until the finer tiles arrive
+constexpr int FeasibilityFallbackLevelNum = 6; // coarser levels a missing cell is drawn from
+constexpr size_t MaxFeasibilityPendingNum = 64;
+constexpr size_t MaxFeasibilityTileNum = 16384; // about 1 KB per tile
+constexpr double TxvidResolution = 0.1;         // grid unit of txvid, other inputs are pixel or line counts
+
+// Conf data loaded in memory, valid for InMemoryDataFileSize/InMemoryDataFileTime/InMemoryDataFileHash
 static std::vector<Conf> InMemoryData;
+static int64_t InMemoryDataFileSize = -1;
+static int64_t InMemoryDataFileTime = -1;
+static uint64_t InMemoryDataFileHash = 0; // utility::HashFileEnds of the loaded file
+static bool InMemoryDataIsRacy = false;   // loaded in the second of its mtime, size and mtime alone can not tell a later rewrite
+
+// immutable versions of InMemoryData for readers, republished by whoever changes InMemoryData
+// the UI draws records from the version it loaded at the start of the frame, a reload never frees them under it
+static snapshot::Publisher<Conf> LibrarySnapshots;
+
+// sidecar index entry, one per "0." record of the Porch Conf file
+struct PorchIndexEntry
+{
+    uint64_t offset = 0;   // byte offset of the "0." line
+    uint64_t nameHash = 0; // hash of the parsed porch name
+    uint32_t checksum = 0; // hash of the record bytes
+};
+
+// sidecar index loaded in memory, valid for PorchIndexFileSize/PorchIndexFileTime/PorchIndexFileHash
+static std::vector<PorchIndexEntry> PorchIndex;
+static int64_t PorchIndexFileSize = -1;
+static int64_t PorchIndexFileTime = -1;
+static uint64_t PorchIndexFileHash = 0; // utility::HashFileEnds of the indexed file
+
+// streaming reader of a Porch Conf file, holds at most one record in memory
+class PorchConfReader
+{
+public:
+    explicit PorchConfReader(const std::string &filePath);
+    bool Next(Conf &conf); // read next record, false at the end of the file or on error
+    bool IsOpen() const { return isOpen; }
+    bool HasError() const { return hasError; }
+
+private:
+    std::ifstream inStream;
+    std::string lineBuf;
+    std::vector<Conf> pending; // record being parsed
+    bool isOpen = false;
+    bool hasError = false;
+};
+
+// CSV and JSON Lines table formats, one row per Conf
+enum class ConfTableFormat
+{
+    Unknown,
+    CSV,
+    JSONL,
+};
+
+// streaming CSV/JSON Lines writer
+class ConfTableWriter
+{
+public:
+    explicit ConfTableWriter(const std::string &filePath);
+    void Write(const Conf &conf);
+    bool Close();
+    bool IsOpen() const { return format != ConfTableFormat::Unknown && writer.IsOpen(); }
+
+private:
+    bufferedio::BufferedWriter writer;
+    ConfTableFormat format;
+};
+
+// streaming CSV/JSON Lines reader, rows go straight into the batch columns
+class ConfTableReader
+{
+public:
+    explicit ConfTableReader(const std::string &filePath);
+    size_t ReadBatch(ConfBatch &batch, size_t maxRecords); // append up to maxRecords rows, 0 at the end of the file or on error
+    bool Next(Conf &conf);                                 // read next row, false at the end of the file or on error
+    bool IsOpen() const { return isOpen; }
+    bool HasError() const { return hasError; }
+
+private:
+    bool ReadRow(std::string &porchName, bool &isDSC, float values[]);
+
+    bufferedio::BufferedLineReader reader;
+    ConfTableFormat format;
+    std::string lineBuf;
+    std::vector<std::string> fields;                         // CSV row
+    std::vector<std::pair<std::string, std::string>> members; // JSON Lines row
+    std::vector<int> columnField;                            // CSV column -> ConfFields index, -1 name, -2 type, -3 unknown
+    float defaultValues[ConfFieldNum];
+    uint64_t lineNum = 0;
+    bool isOpen = false;
+    bool hasError = false;
+};
 
-int main()
+int main(int argc, char *argv[])
 {
-    utility::RescaleWindow(); // calculate screen scale factor
-    utility::WindowInit();    // init glfw and glad
+    if (argc > 1) // command line mode, no window
+        return RunCommandLine(argc, argv);
+
+    return RunWindow(std::string());
+}
+
+// GUI main loop, the input of every frame is recorded to recordPath unless it is empty
+int RunWindow(const std::string &recordPath)
+{
+    utility::WindowInit();    // init glfw and glad, scale factor from the monitor
     utility::GUIInit();       // init imgui
-    utility::GUILoadFont();   // init simplified chinese font
+    utility::GUILoadFont(UIGlyphText); // init simplified chinese font with the characters in use
+    LoadPorchConfFile();      // porch names are in the first font bake
+
+    if (!recordPath.empty())
+    {
+        // window layout the session starts from, imgui.ini is loaded on the first frame
+        std::ifstream iniStream;
+        iniStream.open(ImGui::GetIO().IniFilename, std::ifstream::in | std::ifstream::binary);
+        std::stringstream iniText;
+        if (iniStream)
+            iniText << iniStream.rdbuf();
+        uint64_t libraryHash = utility::HashFileFNV1a64(PorchConfFilePath); // replay refuses a different library
+        if (!inputrecord::GlobalRecorder().Open(recordPath, utility::WindowScaleFactor, libraryHash, iniText.str().c_str()))
+            logger::Error("Unable to write " + recordPath);
+    }
 
     while (!utility::WindowShouldClose())  // close when true
     {
-        utility::WindowNewFrame();  // begin glfw frame
-        utility::GUINewFrame();     // begin imgui frame
+        if (!utility::WindowNewFrame()) // begin glfw frame, minimized: nothing is drawn
+        {
+            LoadPorchConfFile();        // keep watching the conf file
+            continue;
+        }
+
+        {
+            profiler::ScopedTimer timer(FramePhase);
+
+            utility::GUINewFrame();     // begin imgui frame
+
+            MainWindowFunction();       // main window function
+
+            utility::GUIDrawFrame();    // end glfw frame
+            utility::WindowEndFrame();  // end imgui frame
+        }
+        profiler::Frame().EndFrame();   // commit phase times
+    }
 
-        MainWindowFunction();       // main window function
+    PollLibrarySave(true); // the last undo or redo reaches the file
+    CancelSweep(); // the pool is joined at exit, do not wait for a long sweep
+    CloseFeasibilityMap();
 
-        utility::GUIDrawFrame();    // end glfw frame
-        utility::WindowEndFrame();  // end imgui frame
+    if (inputrecord::GlobalRecorder().IsOpen())
+    {
+        std::cout << inputrecord::GlobalRecorder().FrameNum() << " frames recorded" << std::endl;
+        inputrecord::GlobalRecorder().Close();
     }
 
     utility::GUIDestroy();          // deinit imgui
     utility::WindowDestroy();       // deinit glfw
+    return 0;
 }
 
 // logic and UI layout entrance
 void MainWindowFunction()
 {
-    LoadPorchConfFile(); // Load data
+    {
+        profiler::ScopedTimer timer(LoadConfPhase);
+        LoadPorchConfFile(); // Load data
+    }
 
-    ShowMenuBar();       // menu bar layout and logic
+    {
+        profiler::ScopedTimer timer(MenuBarPhase);
+        ShowMenuBar();       // menu bar layout and logic
+    }
 
     ShowWindows();       // show all windows: DSC/NonDSC/PorchFile/Confirm windows
 
@@ -154,6 +753,16 @@ void MainWindowFunction()
 // menu bar UI layout and logic
 void ShowMenuBar()
 {
+    // library and calculator undo, a focused text box keeps Ctrl+Z for its own text
+    ImGuiIO &io = ImGui::GetIO();
+    if (io.KeyCtrl && !io.WantTextInput)
+    {
+        if (ImGui::IsKeyPressed(ImGuiKey_Z, false))
+            UndoEdit();
+        else if (ImGui::IsKeyPressed(ImGuiKey_Y, false))
+            RedoEdit();
+    }
+
     if (ImGui::BeginMainMenuBar())
     {
         if (ImGui::BeginMenu("File"))
@@ -162,6 +771,33 @@ void ShowMenuBar()
             {
                 porchFileIsOpen = true;
             }
+            if (ImGui::BeginMenu("Export"))
+            {
+                if (ImGui::MenuItem("CSV", PorchCsvFilePath.c_str()))
+                    ExportConfTable(PorchConfFilePath, PorchCsvFilePath);
+                if (ImGui::MenuItem("JSON Lines", PorchJsonlFilePath.c_str()))
+                    ExportConfTable(PorchConfFilePath, PorchJsonlFilePath);
+                ImGui::EndMenu();
+            }
+            if (ImGui::BeginMenu("Import"))
+            {
+                if (ImGui::MenuItem("CSV", PorchCsvFilePath.c_str()))
+                    ImportConfTable(PorchCsvFilePath);
+                if (ImGui::MenuItem("JSON Lines", PorchJsonlFilePath.c_str()))
+                    ImportConfTable(PorchJsonlFilePath);
+                ImGui::EndMenu();
+            }
+            if (ImGui::MenuItem("Merge Duplicate Confs"))
+                DedupeInMemoryData();
+            ShowToolTip("合并数值完全相同的配置, 其余名称作为别名保留");
+            ImGui::EndMenu();
+        }
+        if (ImGui::BeginMenu("Edit"))
+        {
+            if (ImGui::MenuItem("Undo", "Ctrl+Z", false, EditHistory.CanUndo()))
+                UndoEdit();
+            if (ImGui::MenuItem("Redo", "Ctrl+Y", false, EditHistory.CanRedo()))
+                RedoEdit();
             ImGui::EndMenu();
         }
         if (ImGui::BeginMenu("Window"))
@@ -184,6 +820,15 @@ void ShowMenuBar()
                 ImGui::InputText("NonDSC Window Name", &NonDSCwindowName);
                 ImGui::EndMenu();
             }
+            ImGui::MenuItem("Log", nullptr, &logIsOpen);
+            if (ImGui::MenuItem("Frame Profiler", nullptr, &profilerIsOpen) && profilerIsOpen)
+                profiler::Frame().Reset();
+            bool isRecording = trace::IsRecording();
+            if (ImGui::MenuItem("Record Trace", nullptr, &isRecording))
+                trace::Recording = isRecording;
+            if (ImGui::MenuItem("Save Trace", PorchTraceFilePath.c_str()) && !trace::WriteChromeTrace(PorchTraceFilePath))
+                logger::Error("Unable to write trace file!");
+            ShowToolTip("保存最近的帧, 文件读写与后台任务耗时, 可用 chrome://tracing 或 Perfetto 打开");
             ImGui::EndMenu();
         }
         ImGui::EndMainMenuBar();
@@ -197,6 +842,7 @@ void ShowWindows()
     {
         if (DSCWindowState[index] == true)
         {
+            profiler::ScopedTimer timer(CalculatorPhase);
             ImGui::Begin(DSCWindowName[index].c_str(), DSCWindowState + index, ImGuiWindowFlags_AlwaysAutoResize);
 
             DSCInput(index);
@@ -210,6 +856,7 @@ void ShowWindows()
     {
         if (NonDSCWindowState[index] == true)
         {
+            profiler::ScopedTimer timer(CalculatorPhase);
             ImGui::Begin(NonDSCWindowName[index].c_str(), NonDSCWindowState + index, ImGuiWindowFlags_AlwaysAutoResize);
 
             NonDSCInput(index);
@@ -221,9 +868,31 @@ void ShowWindows()
 
     if (porchFileIsOpen) // show porch file window
     {
+        profiler::ScopedTimer timer(ConfWindowPhase);
         ShowPorchFileWindow();
     }
 
+    if (logIsOpen) // show log window
+    {
+        ShowLogWindow();
+    }
+
+    if (sweepIsOpen) // show HFP sweep plots
+    {
+        ShowSweepWindow();
+    }
+
+    if (feasibilityIsOpen) // show feasibility map
+    {
+        ShowFeasibilityWindow();
+    }
+
+    profiler::IsEnabled = profilerIsOpen;
+    if (profilerIsOpen) // show frame profiler overlay
+    {
+        ShowProfilerWindow();
+    }
+
     if (confirmDeletePorchIsOpen) // show confirm delete window
     {
         ShowConfirmDeleteWindow();
@@ -236,25 +905,104 @@ void ShowPorchFileWindow()
     if (!LoadPorchConfFile())
         return;
 
+    // one version for the whole frame, records never change under the draw calls
+    snapshot::Publisher<Conf>::Snapshot library = LibrarySnapshots.Load();
+    const snapshot::ChunkedList<Conf> &data = *library;
+
     ImGui::SetNextWindowSize(ImVec2(500 * utility::WindowScaleFactor, 440 * utility::WindowScaleFactor));
     if (ImGui::Begin("Porch Conf Window", &porchFileIsOpen, ImGuiWindowFlags_AlwaysAutoResize))
     {
-        if (InMemoryData.empty())
+        if (data.Empty())
         {
             ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "No Conf exists.");
             ImGui::End();
             return;
         }
 
+        // Search box answered by the name index, filter bar answered by the range index
+        static std::string nameQueryText;
+        static std::vector<uint32_t> searchedIds;
+        static uint64_t searchedVersion = UINT64_MAX;
+        static std::string rangeQueryText;
+        static std::string rangeQueryMessage;
+        static std::vector<RangeQueryTerm> rangeQuery;
+        static std::vector<uint32_t> rangeIds;
+        static uint64_t rangeVersion = UINT64_MAX;
+        static std::vector<uint32_t> filteredIds;
+        {
+            bool isFilterStale = false; // filteredIds is only rebuilt when one of its inputs changed
+            bool isSearchChanged = ImGui::InputTextWithHint("Search", "porch name", &nameQueryText);
+            ShowToolTip("按名称模糊搜索, 以空格分隔的每个词都需要出现在名称中, 结果按匹配程度排序\n之后列出拼写相近的名称 (每个词允许少量错字)");
+            if (isSearchChanged || searchedVersion != InMemoryNameIndex.Version())
+            {
+                InMemoryNameIndex.Search(nameQueryText, searchedIds);
+                for (auto &id : searchedIds) // record ids to InMemoryData indices
+                    id = InMemoryRecordIds.Position(id);
+                searchedVersion = InMemoryNameIndex.Version();
+                isFilterStale = true;
+            }
+
+            bool isChanged = ImGui::InputTextWithHint("Filter", "fps=59.9..60.1 minimum_lane_rate=..1000 hactive=1080", &rangeQueryText);
+            ShowToolTip("以空格分隔多个条件: 字段=下限..上限, 字段=下限.., 字段=..上限 或 字段=值\n字段: txvid hactive vactive htotal vtotal adj_vactive adj_hactive HFP HSYNC HBP fps minimum_lane_rate ...");
+            if (isChanged && !ParseRangeQuery(rangeQueryText, rangeQuery, rangeQueryMessage))
+                rangeQuery.clear();
+            else if (isChanged)
+                rangeQueryMessage.clear();
+
+            if (isChanged || rangeVersion != InMemoryRangeIndex.Version())
+            {
+                InMemoryRangeIndex.Query(InMemoryData, InMemoryRecordIds, rangeQuery, rangeIds);
+                rangeVersion = InMemoryRangeIndex.Version();
+                isFilterStale = true;
+            }
+
+            // search order, limited to the ids passing the filter, marked in isRangeId and unmarked again
+            static std::vector<char> isRangeId;
+            if (isFilterStale && nameQueryText.find_first_not_of(' ') == std::string::npos)
+                filteredIds = rangeIds;
+            else if (isFilterStale && rangeQuery.empty())
+                filteredIds = searchedIds;
+            else if (isFilterStale)
+            {
+                isRangeId.resize(InMemoryData.size());
+                for (auto id : rangeIds)
+                    isRangeId[id] = 1;
+                filteredIds.clear();
+                for (auto id : searchedIds)
+                {
+                    if (id < isRangeId.size() && isRangeId[id])
+                        filteredIds.push_back(id);
+                }
+                for (auto id : rangeIds)
+                    isRangeId[id] = 0;
+            }
+
+            if (!rangeQueryMessage.empty())
+                ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%s", rangeQueryMessage.c_str());
+            else
+                ImGui::Text("%d / %d", static_cast<int>(filteredIds.size()), static_cast<int>(data.Size()));
+        }
+
         // Left
         static int selected = 0;
+        if (selected >= static_cast<int>(data.Size()))
+            selected = static_cast<int>(data.Size()) - 1;
         {
             ImGui::BeginChild("left pane", ImVec2(150 * utility::WindowScaleFactor, 0), true);
-            for (int i = 0; i < InMemoryData.size(); i++)
+            ImGuiListClipper clipper; // only visible rows are submitted
+            clipper.Begin(static_cast<int>(filteredIds.size()));
+            while (clipper.Step())
             {
-                std::string label1 = InMemoryData[i].porchName;
-                if (ImGui::Selectable(label1.c_str(), selected == i))
-                    selected = i;
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+                {
+                    int i = static_cast<int>(filteredIds[row]);
+                    if (i >= static_cast<int>(data.Size())) // index of a newer version
+                        continue;
+                    ImGui::PushID(i);
+                    if (ImGui::Selectable(data[i].porchName.c_str(), selected == i))
+                        selected = i;
+                    ImGui::PopID();
+                }
             }
             ImGui::EndChild();
         }
@@ -264,49 +1012,77 @@ void ShowPorchFileWindow()
         {
             ImGui::BeginGroup();
             ImGui::BeginChild("item view", ImVec2(0, -ImGui::GetFrameHeightWithSpacing())); // Leave room for 1 line below us
-            ImGui::Text(InMemoryData[selected].porchName.c_str());
-            ImGui::SameLine();
-            ImGui::Text(InMemoryData[selected].isDSC == true ? "DSC" : "NonDSC");
-            ImGui::Separator();
-
-            ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "txvid:");
-            ImGui::Text(std::to_string(InMemoryData[selected].txvid).c_str());
-            ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "hactive:");
-            ImGui::Text(std::to_string(InMemoryData[selected].hactive).c_str());
-            ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "vactive:");
-            ImGui::Text(std::to_string(InMemoryData[selected].vactive).c_str());
-            ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "htotal:");
-            ImGui::Text(std::to_string(InMemoryData[selected].htotal).c_str());
-            ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "vtotal:");
-            ImGui::Text(std::to_string(InMemoryData[selected].vtotal).c_str());
-            ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "adj_vactive:");
-            ImGui::Text(std::to_string(InMemoryData[selected].adjVactive).c_str());
-            ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "adj_hactive:");
-            ImGui::Text(std::to_string(InMemoryData[selected].adjHactive).c_str());
-            ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "HFP:");
-            ImGui::Text(std::to_string(InMemoryData[selected].HFP).c_str());
-            ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "HSYNC:");
-            ImGui::Text(std::to_string(InMemoryData[selected].HSYNC).c_str());
-            ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "HBP:");
-            ImGui::Text(std::to_string(InMemoryData[selected].HBP).c_str());
-
-            ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "帧率:");
-            ImGui::Text(std::to_string(InMemoryData[selected].fps).c_str());
-            ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "adj_htotal:");
-            ImGui::Text(std::to_string(InMemoryData[selected].adjHtotal).c_str());
-            ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "adj_hblank:");
-            ImGui::Text(std::to_string(InMemoryData[selected].adjHblank).c_str());
-            ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "进 LP 时最小 HLINE:");
-            ImGui::Text(std::to_string(InMemoryData[selected].minimumHline).c_str());
-            ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "切 LP mode, Lane 速率至少需要达到的值:");
-            ImGui::Text(std::to_string(InMemoryData[selected].minimumLaneRateSwitchToLPMode).c_str());
-
-            if (InMemoryData[selected].isDSC)
-            {
-                ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "adj_hblank - 40:");
-                ImGui::Text(std::to_string(InMemoryData[selected].adjHblankMinus40).c_str());
-                ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "hblank - 40:");
-                ImGui::Text(std::to_string(InMemoryData[selected].hblankMinus40).c_str());
+
+            // the fields only change with the selection or a new library version, their geometry is replayed otherwise
+            if (drawcache::Begin("fields", data.Version() << 32 | static_cast<uint32_t>(selected)))
+            {
+                ImGui::Text(data[selected].porchName.c_str());
+                ImGui::SameLine();
+                ImGui::Text(data[selected].isDSC == true ? "DSC" : "NonDSC");
+                ImGui::Separator();
+
+                ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "txvid:");
+                ImGui::Text(std::to_string(data[selected].txvid).c_str());
+                ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "hactive:");
+                ImGui::Text(std::to_string(data[selected].hactive).c_str());
+                ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "vactive:");
+                ImGui::Text(std::to_string(data[selected].vactive).c_str());
+                ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "htotal:");
+                ImGui::Text(std::to_string(data[selected].htotal).c_str());
+                ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "vtotal:");
+                ImGui::Text(std::to_string(data[selected].vtotal).c_str());
+                ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "adj_vactive:");
+                ImGui::Text(std::to_string(data[selected].adjVactive).c_str());
+                ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "adj_hactive:");
+                ImGui::Text(std::to_string(data[selected].adjHactive).c_str());
+                ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "HFP:");
+                ImGui::Text(std::to_string(data[selected].HFP).c_str());
+                ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "HSYNC:");
+                ImGui::Text(std::to_string(data[selected].HSYNC).c_str());
+                ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "HBP:");
+                ImGui::Text(std::to_string(data[selected].HBP).c_str());
+
+                ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "帧率:");
+                ImGui::Text(std::to_string(data[selected].fps).c_str());
+                ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "adj_htotal:");
+                ImGui::Text(std::to_string(data[selected].adjHtotal).c_str());
+                ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "adj_hblank:");
+                ImGui::Text(std::to_string(data[selected].adjHblank).c_str());
+                ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "进 LP 时最小 HLINE:");
+                ImGui::Text(std::to_string(data[selected].minimumHline).c_str());
+                ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "切 LP mode, Lane 速率至少需要达到的值:");
+                ImGui::Text(std::to_string(data[selected].minimumLaneRateSwitchToLPMode).c_str());
+
+                if (data[selected].isDSC)
+                {
+                    ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "adj_hblank - 40:");
+                    ImGui::Text(std::to_string(data[selected].adjHblankMinus40).c_str());
+                    ImGui::TextColored(ImVec4(1.0f, 0.92156f, 0.80392f, 1.0f), "hblank - 40:");
+                    ImGui::Text(std::to_string(data[selected].hblankMinus40).c_str());
+                }
+
+                ImGui::Separator();
+                ImGui::TextColored(ImVec4(0.74117f, 0.98823f, 0.78823f, 1.0f), "Similar:");
+            }
+            drawcache::End();
+            static int similarSelected = -1;
+            static uint64_t similarVersion = UINT64_MAX;
+            static std::vector<ConfSimilarIndex::Neighbor> similarIds;
+            if (similarSelected != selected || similarVersion != InMemorySimilarIndex.Version())
+            {
+                InMemorySimilarIndex.Query(data[selected], InMemoryRecordIds, SimilarConfNum + 1, similarIds);
+                similarSelected = selected;
+                similarVersion = InMemorySimilarIndex.Version();
+            }
+            for (auto &it : similarIds)
+            {
+                int i = static_cast<int>(it.second);
+                if (i == selected || i >= static_cast<int>(data.Size()))
+                    continue;
+                ImGui::PushID(i);
+                if (ImGui::Selectable(data[i].porchName.c_str()))
+                    selected = i;
+                ImGui::PopID();
             }
 
             ImGui::EndChild();
@@ -327,6 +1103,7 @@ void ShowConfirmDeleteWindow()
     ImGui::Begin("Confirm Delete Conf", &confirmDeletePorchIsOpen, ImGuiWindowFlags_AlwaysAutoResize);
 
     ImGui::Text("您是否想删除该配置?");
+    ImGui::Text("删除后可通过 Edit -> Undo (Ctrl+Z) 撤销");
 
     if (ImGui::Button("是"))
     {
@@ -342,66 +1119,410 @@ void ShowConfirmDeleteWindow()
     ImGui::End();
 }
 
-// show tooltip helper
-void ShowToolTip(const char *message)
+// frame profiler overlay, p50/p99 of every phase over the last few seconds
+void ShowProfilerWindow()
 {
-    if (ImGui::IsItemHovered())
+    profiler::FrameProfiler &frame = profiler::Frame();
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    if (!ImGui::Begin("Frame Profiler", &profilerIsOpen, ImGuiWindowFlags_AlwaysAutoResize))
     {
-        ImGui::BeginTooltip();
-        ImGui::Text(message);
-        ImGui::EndTooltip();
+        ImGui::End();
+        return;
     }
-}
 
-// update DSC/NonDSC window name
-void UpdateWindows()
-{
-    for (int i = 0; i < MaxDSCWindowNum; i++)
-    {
-        if (DSCWindowState[i] == false)
-            DSCWindowName[i] = "NULL";
-    }
-    for (int i = 0; i < MaxNonDSCWindowNum; i++)
+    ImGui::Text("%d frames", static_cast<int>(frame.FilledNum()));
+    if (ImGui::BeginTable("phases", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
     {
-        if (NonDSCWindowState[i] == false)
-            NonDSCWindowName[i] = "NULL";
+        ImGui::TableSetupColumn("phase");
+        ImGui::TableSetupColumn("last ms");
+        ImGui::TableSetupColumn("p50 ms");
+        ImGui::TableSetupColumn("p99 ms");
+        ImGui::TableHeadersRow();
+        for (int phase = 0; phase < static_cast<int>(frame.PhaseNum()); phase++)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", frame.Name(phase));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", frame.Last(phase));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", frame.Percentile(phase, 0.5f));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", frame.Percentile(phase, 0.99f));
+        }
+        ImGui::EndTable();
     }
+
+    ImGui::PlotLines("frame ms", frame.Samples(FramePhase), static_cast<int>(frame.FilledNum()), frame.Offset(), nullptr, 0.0f, FLT_MAX, ImVec2(0, 60 * utility::WindowScaleFactor));
+
+    // vertex and index bytes of the last rendered frame, written into the mapped ring or handed to glBufferData
+    bool isStreaming = ImGui_ImplOpenGL3_IsBufferStreaming();
+    ImGui::Text("upload %.1f KB/frame", static_cast<double>(ImGui_ImplOpenGL3_GetUploadBytes()) / 1024.0);
+    ImGui::SameLine();
+    if (ImGui::Checkbox("mapped ring", &isStreaming) && !ImGui_ImplOpenGL3_SetBufferStreaming(isStreaming))
+        logger::Warning("Persistently mapped buffers are not supported, uploading with glBufferData");
+    ImGui::End();
 }
 
-// add DSC window
-void AddDSCWindow(std::string windowName)
+// log window, the newest records of the in-memory log with repeat counts
+void ShowLogWindow()
 {
-    if (windowName.empty() || windowName == "")
+    static bool isShown[3] = {true, true, true}; // by severity
+    static uint64_t clearedEnd = 0;
+    static bool isAutoScroll = true;
+
+    ImGui::SetNextWindowSize(ImVec2(600 * utility::WindowScaleFactor, 300 * utility::WindowScaleFactor), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Log", &logIsOpen))
+    {
+        ImGui::End();
         return;
+    }
 
-    for (auto &it : DSCWindowName)
-        if (it == windowName + " | DSC")
-            return;
+    logger::Logger &log = logger::GlobalLogger();
+    uint64_t end = log.End();
+    ImGui::Checkbox("Info", isShown + 0);
+    ImGui::SameLine();
+    ImGui::Checkbox("Warning", isShown + 1);
+    ImGui::SameLine();
+    ImGui::Checkbox("Error", isShown + 2);
+    ImGui::SameLine();
+    if (ImGui::Button("Clear"))
+        clearedEnd = end;
+    ImGui::SameLine();
+    ImGui::Checkbox("Auto Scroll", &isAutoScroll);
+    if (log.SuppressedNum() > 0)
+    {
+        ImGui::SameLine();
+        ImGui::Text("(%llu lines not printed to console)", static_cast<unsigned long long>(log.SuppressedNum()));
+    }
+    ImGui::Separator();
 
-    int index = 0;
-    for (; index < MaxDSCWindowNum; index++)
+    static std::vector<logger::Entry> entries;
+    entries.clear();
+    uint64_t first = std::max<uint64_t>(clearedEnd, end > logger::RecordCapacity ? end - logger::RecordCapacity : 0);
+    logger::Entry entry;
+    for (uint64_t i = first; i < end; i++)
     {
-        if (DSCWindowState[index] == false)
+        if (log.Read(i, entry) && isShown[static_cast<int>(entry.severity)])
+            entries.push_back(entry);
+    }
+
+    const ImVec4 Colors[] = {ImVec4(0.8f, 0.8f, 0.8f, 1.0f), ImVec4(1.0f, 0.8f, 0.3f, 1.0f), ImVec4(1.0f, 0.4f, 0.4f, 1.0f)};
+    ImGui::BeginChild("log records");
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(entries.size()));
+    while (clipper.Step())
+    {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
         {
-            DSCWindowState[index] = true;
-            break;
+            const logger::Entry &it = entries[row];
+            ImGui::TextColored(Colors[static_cast<int>(it.severity)], "[%8.2f] %s", it.firstSeconds, it.text.c_str());
+            if (it.repeatCount > 1)
+            {
+                ImGui::SameLine();
+                ImGui::TextDisabled("x%u, last %.2f", it.repeatCount, it.lastSeconds);
+            }
         }
     }
+    if (isAutoScroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
+        ImGui::SetScrollHereY(1.0f);
+    ImGui::EndChild();
+    ImGui::End();
+}
 
-    if (index >= MaxDSCWindowNum)
-        return;
-
-    DSCWindowName[index] = windowName + " | DSC";
+// show tooltip helper
+void ShowToolTip(const char *message)
+{
+    if (ImGui::IsItemHovered())
+    {
+        ImGui::BeginTooltip();
+        if (drawcache::Begin("message", drawcache::HashText(message)))
+            ImGui::Text(message);
+        drawcache::End();
+        ImGui::EndTooltip();
+    }
 }
 
-// add NonDSC window
-void AddNonDSCWindow(std::string windowName)
+// saved confs closest to the window inputs, inputs are the ten input buffers in ConfFields order
+void ShowSimilarConfs(std::string *inputs[])
 {
-    if (windowName.empty() || windowName == "")
+    if (!ImGui::CollapsingHeader("Find Similar"))
         return;
+    ShowToolTip("按 txvid, hactive, vactive, htotal, vtotal, HFP, HSYNC, HBP 查找最接近的已保存配置, 未填写的输入不参与比较");
 
-    for (auto &it : NonDSCWindowName)
-        if (it == windowName + " | NonDSC")
+    Conf conf;
+    for (int i = 0; i < 10; i++)
+    {
+        char *end = nullptr;
+        float value = std::strtof(inputs[i]->c_str(), &end);
+        conf.*ConfFields[i].member = !inputs[i]->empty() && end == inputs[i]->c_str() + inputs[i]->size() ? value : std::numeric_limits<float>::quiet_NaN();
+    }
+
+    snapshot::Publisher<Conf>::Snapshot library = LibrarySnapshots.Load();
+    std::vector<ConfSimilarIndex::Neighbor> neighbors;
+    InMemorySimilarIndex.Query(conf, InMemoryRecordIds, SimilarConfNum, neighbors);
+    if (neighbors.empty())
+        ImGui::Text("No Conf exists.");
+
+    for (auto &it : neighbors)
+    {
+        if (it.second >= library->Size()) // index of a newer version
+            continue;
+        const Conf &similar = (*library)[it.second];
+        ImGui::PushID(static_cast<int>(it.second));
+        if (ImGui::SmallButton("Use")) // start from the saved inputs, one undo step restores all of them
+        {
+            HistoryEdit edit;
+            for (int i = 0; i < 10; i++)
+            {
+                char number[32];
+                std::string before = *inputs[i];
+                inputs[i]->assign(number, static_cast<size_t>(bufferedio::FormatFloat(similar.*ConfFields[i].member, number)));
+                if (before != *inputs[i])
+                    PushInputEdit(edit, inputs[i], before);
+            }
+            if (!edit.inputs.empty())
+                EditHistory.Push(std::move(edit));
+        }
+        ImGui::SameLine();
+        ImGui::Text("%s | %s  (%.3f)", similar.porchName.c_str(), similar.isDSC ? "DSC" : "NonDSC", std::sqrt(it.first));
+        ImGui::PopID();
+    }
+}
+
+// sweep range of a calculator window, every input has to be filled in
+void ShowSweepControls(std::string *inputs[], bool isDSC)
+{
+    if (!ImGui::CollapsingHeader("HFP Sweep"))
+        return;
+    ShowToolTip("在 HFP 的取值范围内计算帧率与 lane 速率曲线, htotal 随 HFP 同步变化");
+
+    static float from = 0.0f;
+    static float to = 1000.0f;
+    static int pointNum = 1000000;
+    ImGui::InputFloat("HFP from", &from, 0.0f, 0.0f, "%.0f");
+    ImGui::InputFloat("HFP to", &to, 0.0f, 0.0f, "%.0f");
+    ImGui::InputInt("points", &pointNum, 0, 0);
+    pointNum = std::max(2, std::min(pointNum, static_cast<int>(MaxSweepPointNum)));
+
+    Conf conf;
+    bool isFilled = ParseCalculatorInputs(inputs, isDSC, conf);
+    ImGui::BeginDisabled(!isFilled || !(from < to));
+    if (ImGui::Button("Start Sweep"))
+        StartSweep(conf, from, to, static_cast<size_t>(pointNum));
+    ImGui::EndDisabled();
+}
+
+// fps and minimum lane rate over the swept HFP, plots are decimated per pixel column so they cost the same for any point count
+void ShowSweepWindow()
+{
+    if (HfpSweep.queue)
+    {
+        HfpSweep.queue->Drain(SweepFpsSeries, HfpSweep.fps);
+        HfpSweep.queue->Drain(SweepLaneRateSeries, HfpSweep.laneRate);
+    }
+
+    ImGui::SetNextWindowSize(ImVec2(640 * utility::WindowScaleFactor, 480 * utility::WindowScaleFactor), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("HFP Sweep", &sweepIsOpen))
+    {
+        ImGui::End();
+        return;
+    }
+
+    int doneNum = static_cast<int>(HfpSweep.laneRate.Size());
+    int pointNum = static_cast<int>(HfpSweep.pointNum);
+    char progress[64];
+    std::snprintf(progress, sizeof(progress), "%d / %d", doneNum, pointNum);
+    ImGui::ProgressBar(pointNum > 0 ? static_cast<float>(doneNum) / pointNum : 0.0f, ImVec2(300 * utility::WindowScaleFactor, 0), progress);
+    if (doneNum < pointNum && !HfpSweep.token.IsCancelled())
+    {
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel"))
+            CancelSweep();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100 * utility::WindowScaleFactor);
+    ImGui::InputFloat("PHY limit", &PhyLaneRateLimit, 0.0f, 0.0f, "%.0f");
+    ShowToolTip("每条 lane 的 PHY 速率上限 (Mbps), 在 lane 速率曲线上画为红线");
+
+    float plotHeight = std::max(ImGui::GetTextLineHeight() * 4, (ImGui::GetContentRegionAvail().y - ImGui::GetStyle().ItemSpacing.y) / 2);
+    sweepplot::PlotSeries("fps", HfpSweep.fps, HfpSweep.pointNum, HfpSweep.from, HfpSweep.step, HfpSweep.view, nullptr, ImVec2(-FLT_MIN, plotHeight));
+    sweepplot::PlotSeries("minimum lane rate", HfpSweep.laneRate, HfpSweep.pointNum, HfpSweep.from, HfpSweep.step, HfpSweep.view, &PhyLaneRateLimit, ImVec2(-FLT_MIN, plotHeight));
+    ImGui::End();
+
+    if (!sweepIsOpen)
+        CancelSweep();
+}
+
+// open the feasibility map around the inputs of a calculator window
+void ShowFeasibilityControls(std::string *inputs[], bool isDSC)
+{
+    if (!ImGui::CollapsingHeader("Feasibility Map"))
+        return;
+    ShowToolTip("以两个输入参数为坐标轴, 显示帧率在范围内且 lane 速率不超过上限的区域, 其余输入取当前值");
+
+    Conf conf;
+    bool isFilled = ParseCalculatorInputs(inputs, isDSC, conf);
+    ImGui::BeginDisabled(!isFilled);
+    if (ImGui::Button("Open Map"))
+        OpenFeasibilityMap(conf);
+    ImGui::EndDisabled();
+}
+
+// inner function
+static bool ShowFieldCombo(const char *label, int &field)
+{
+    bool isChanged = false;
+    ImGui::SetNextItemWidth(100 * utility::WindowScaleFactor);
+    if (ImGui::BeginCombo(label, ConfFields[field].name))
+    {
+        for (int i = 0; i < 10; i++) // calculator inputs
+        {
+            if (ImGui::Selectable(ConfFields[i].name, i == field) && i != field)
+            {
+                field = i;
+                isChanged = true;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    return isChanged;
+}
+
+// feasibility map of the two chosen inputs, drag to pan, wheel to zoom, double click to see the inputs again
+void ShowFeasibilityWindow()
+{
+    FeasibilityMap &map = Feasibility;
+    ImGui::SetNextWindowSize(ImVec2(640 * utility::WindowScaleFactor, 560 * utility::WindowScaleFactor), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Feasibility Map", &feasibilityIsOpen))
+    {
+        ImGui::End();
+        return;
+    }
+
+    bool isAxisChanged = ShowFieldCombo("x", map.xField);
+    ImGui::SameLine();
+    isAxisChanged = ShowFieldCombo("y", map.yField) || isAxisChanged;
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(160 * utility::WindowScaleFactor);
+    bool isLimitChanged = ImGui::InputFloat2("fps range", map.fpsRange, "%.2f");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(80 * utility::WindowScaleFactor);
+    ImGui::InputFloat("PHY limit", &PhyLaneRateLimit, 0.0f, 0.0f, "%.0f");
+    ShowToolTip("每条 lane 的 PHY 速率上限 (Mbps), 与 HFP Sweep 共用");
+    if (isAxisChanged || isLimitChanged || map.laneRateLimit != PhyLaneRateLimit)
+        ResetFeasibilityMap(isAxisChanged);
+
+    for (int i = 0; i <= InvalidInput; i++) // legend
+    {
+        ImGui::ColorButton(FeasibilityNames[i], ImGui::ColorConvertU32ToFloat4(FeasibilityColors[i]), ImGuiColorEditFlags_NoTooltip, ImVec2(ImGui::GetTextLineHeight(), ImGui::GetTextLineHeight()));
+        ImGui::SameLine(0.0f, ImGui::GetStyle().ItemInnerSpacing.x);
+        ImGui::TextUnformatted(FeasibilityNames[i]);
+        ImGui::SameLine();
+    }
+    ImGui::NewLine();
+    ImGui::TextDisabled("%zu tiles (%zu pending), %zu points evaluated", map.cache.Size(), map.pending.size(), map.evaluatedNum);
+
+    UpdateFeasibilityMap(ImGui::GetContentRegionAvail());
+    double xResolution = map.xField == 0 ? TxvidResolution : 1.0, yResolution = map.yField == 0 ? TxvidResolution : 1.0;
+    ImVec2 marker(map.base.*ConfFields[map.xField].member, map.base.*ConfFields[map.yField].member);
+    ImVec2 value;
+    char label[64];
+    std::snprintf(label, sizeof(label), "%s x %s", ConfFields[map.xField].name, ConfFields[map.yField].name);
+    if (heatmap::PlotMap(label, map.view, map.home, ImVec2(static_cast<float>(8 * xResolution), static_cast<float>(8 * yResolution)), map.texture, map.image, marker, ImVec2(-FLT_MIN, -FLT_MIN), value))
+    {
+        // the hovered grid point, computed here so the tooltip shows the numbers behind the color
+        Conf conf = map.base;
+        conf.*ConfFields[map.xField].member = static_cast<float>(std::floor(value.x / xResolution) * xResolution);
+        conf.*ConfFields[map.yField].member = static_cast<float>(std::floor(value.y / yResolution) * yResolution);
+        RecomputeConf(conf);
+        ImGui::SetTooltip("%s %.6g, %s %.6g\nfps %.3f\nminimum lane rate %.0f", ConfFields[map.xField].name, conf.*ConfFields[map.xField].member,
+                          ConfFields[map.yField].name, conf.*ConfFields[map.yField].member, conf.fps, conf.minimumLaneRateSwitchToLPMode);
+    }
+    ImGui::End();
+
+    if (!feasibilityIsOpen)
+        CloseFeasibilityMap();
+}
+
+// InputText whose finished edits go to the edit history, typing inside the box keeps ImGui's own undo
+bool InputTextWithHistory(const char *label, std::string *input, ImGuiInputTextFlags flags)
+{
+    static std::string before; // text of the active input when it was activated, only one input is active at a time
+
+    bool isChanged = ImGui::InputText(label, input, flags);
+    if (ImGui::IsItemActivated())
+        before = *input;
+    if (ImGui::IsItemDeactivatedAfterEdit() && before != *input)
+    {
+        HistoryEdit edit;
+        PushInputEdit(edit, input, before);
+        if (!edit.inputs.empty())
+            EditHistory.Push(std::move(edit));
+    }
+    return isChanged;
+}
+
+// update DSC/NonDSC window name
+void UpdateWindows()
+{
+    for (int i = 0; i < MaxDSCWindowNum; i++)
+    {
+        if (DSCWindowState[i] == false)
+            DSCWindowName[i] = "NULL";
+        if (DSCWindowState[i] == false && DSCWindowId[i] != 0) // closed this frame
+        {
+            DropWindowEdits(DSCWindowId[i]);
+            DSCWindowId[i] = 0;
+        }
+    }
+    for (int i = 0; i < MaxNonDSCWindowNum; i++)
+    {
+        if (NonDSCWindowState[i] == false)
+            NonDSCWindowName[i] = "NULL";
+        if (NonDSCWindowState[i] == false && NonDSCWindowId[i] != 0)
+        {
+            DropWindowEdits(NonDSCWindowId[i]);
+            NonDSCWindowId[i] = 0;
+        }
+    }
+}
+
+// add DSC window
+void AddDSCWindow(std::string windowName)
+{
+    if (windowName.empty() || windowName == "")
+        return;
+
+    for (auto &it : DSCWindowName)
+        if (it == windowName + " | DSC")
+            return;
+
+    int index = 0;
+    for (; index < MaxDSCWindowNum; index++)
+    {
+        if (DSCWindowState[index] == false)
+        {
+            DSCWindowState[index] = true;
+            break;
+        }
+    }
+
+    if (index >= MaxDSCWindowNum)
+        return;
+
+    DSCWindowName[index] = windowName + " | DSC";
+    DSCWindowId[index] = NextCalculatorWindowId++;
+}
+
+// add NonDSC window
+void AddNonDSCWindow(std::string windowName)
+{
+    if (windowName.empty() || windowName == "")
+        return;
+
+    for (auto &it : NonDSCWindowName)
+        if (it == windowName + " | NonDSC")
             return;
 
     int index = 0;
@@ -418,73 +1539,74 @@ void AddNonDSCWindow(std::string windowName)
         return;
 
     NonDSCWindowName[index] = windowName + " | NonDSC";
+    NonDSCWindowId[index] = NextCalculatorWindowId++;
 }
 
 // handle DSC window input filed
 void DSCInput(int index)
 {
-    ImGui::InputText("txvid", &DSCInputTxvid[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("txvid", &DSCInputTxvid[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("video tx 端时钟速率");
 
-    ImGui::InputText("hactive", &DSCInputHactive[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("hactive", &DSCInputHactive[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("主机端发出的 H 方向分辨率");
 
-    ImGui::InputText("vactive", &DSCInputVactive[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("vactive", &DSCInputVactive[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("主机端发出的 V 方向分辨率");
 
-    ImGui::InputText("htotal", &DSCInputHtotal[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("htotal", &DSCInputHtotal[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("按此 H 方向配置从 DSC 模块解压图像。\n建议: 将 hsync + hbp 固定为40, 只调hfp。\nHtotal = RX_Hactive + Rx_HSYNC + Rx_HBP + Rx_HFP。\n例如 Htotal = 1080 + 10 + 60 + 30 = 1180");
 
-    ImGui::InputText("vtotal", &DSCInputVtotal[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("vtotal", &DSCInputVtotal[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("按此 V 方向配置从 DSC 模块解压图像。\nVtotal = Rx_Vactive + VSYNC + VFP + VBP\nV 方向的 Porch 值与 TX 屏端的 Porch 值一致。\n例如 Vtotal = 2400 + 4 + 124 + 22 = 2550");
 
-    ImGui::InputText("adj_vactive", &DSCInputAdjVactive[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("adj_vactive", &DSCInputAdjVactive[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("该参数为屏端实际要求 V 方向分辨率");
 
-    ImGui::InputText("adj_hactive", &DSCInputAdjHactive[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("adj_hactive", &DSCInputAdjHactive[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("该参数为屏端实际要求 H 方向分辨率");
 
-    ImGui::InputText("HFP", &DSCInputHFP[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("HFP", &DSCInputHFP[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("寄存器配置中没有这一项按照 HLINE 来求。\nHFP = Hline - TX_Hactive * 3 / 4 - TX_HSYNC - TX_HBP\n例如 HFP = 1042 - 720 * 3 / 4 - 4 - 48 =  450\n在表格中还是填写推荐的 Porch 参与计算, 在代码中填写计算后的数据");
 
-    ImGui::InputText("HSYNC", &DSCInputHSYNC[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("HSYNC", &DSCInputHSYNC[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("适配屏端参数");
 
-    ImGui::InputText("HBP", &DSCInputHBP[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("HBP", &DSCInputHBP[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("适配屏端参数");
 }
 
 // handle NonDSC window input filed
 void NonDSCInput(int index)
 {
-    ImGui::InputText("txvid", &NonDSCInputTxvid[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("txvid", &NonDSCInputTxvid[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("video tx 端时钟速率");
 
-    ImGui::InputText("hactive", &NonDSCInputHactive[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("hactive", &NonDSCInputHactive[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("缩放后 H 方向分辨率");
 
-    ImGui::InputText("vactive", &NonDSCInputVactive[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("vactive", &NonDSCInputVactive[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("缩放后 V 方向分辨率");
 
-    ImGui::InputText("htotal", &NonDSCInputHtotal[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("htotal", &NonDSCInputHtotal[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("video 输出端 H 方向配置\n建议: 将 hsync + hbp 固定为40, 只调hfp。\nHtotal = TX_Hactive + Adj_HSYNC + AdjHBP + AdjHFP\n例如 Htotal = 720 + 16 + 45 + 574 = 1355");
 
-    ImGui::InputText("vtotal", &NonDSCInputVtotal[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("vtotal", &NonDSCInputVtotal[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("video 输出端 V 方向配置\nVtotal = Tx_active + TX_VSYNC + TX_VBP + TX_VFP 例如 Vtotal = 1600 + 8 + 130 + 110 = 1848");
 
-    ImGui::InputText("adj_vactive", &NonDSCInputAdjVactive[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("adj_vactive", &NonDSCInputAdjVactive[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("该参数为屏端实际要求 V 方向分辨率");
 
-    ImGui::InputText("adj_hactive", &NonDSCInputAdjHactive[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("adj_hactive", &NonDSCInputAdjHactive[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("该参数为屏端实际要求 H 方向分辨率");
 
-    ImGui::InputText("HFP", &NonDSCInputHFP[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("HFP", &NonDSCInputHFP[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("寄存器配置中没有这一项按照 HLINE 来求。\n HFP = Hline - TX_Hactive * 3 / 4 - TX_HSYNC - TX_HBP\n例如 HFP = 1054 - 720 * 3 / 4 - 16 - 45 = 453\n在表格中还是填写推荐的 Porch 参与计算, 在代码中填写计算后的数据");
 
-    ImGui::InputText("HSYNC", &NonDSCInputHSYNC[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("HSYNC", &NonDSCInputHSYNC[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("适配屏端参数");
 
-    ImGui::InputText("HBP", &NonDSCInputHBP[index], ImGuiInputTextFlags_CharsDecimal);
+    InputTextWithHistory("HBP", &NonDSCInputHBP[index], ImGuiInputTextFlags_CharsDecimal);
     ShowToolTip("适配屏端参数");
 }
 
@@ -593,6 +1715,14 @@ void DSCCalculateAndShow(int index)
     else
         ImGui::Text("Unsaved.");
     ShowToolTip("You must type all data to save it into the PorchConf.txt file.");
+    if (isSave && !DSCDuplicateName[index].empty())
+        ImGui::TextColored(ImVec4(1.0f, 0.85f, 0.0f, 1.0f), "与已保存的配置 %s 数值相同", DSCDuplicateName[index].c_str());
+
+    std::string *inputs[] = {&DSCInputTxvid[index], &DSCInputHactive[index], &DSCInputVactive[index], &DSCInputHtotal[index], &DSCInputVtotal[index],
+                             &DSCInputAdjVactive[index], &DSCInputAdjHactive[index], &DSCInputHFP[index], &DSCInputHSYNC[index], &DSCInputHBP[index]};
+    ShowSimilarConfs(inputs);
+    ShowSweepControls(inputs, true);
+    ShowFeasibilityControls(inputs, true);
 }
 
 // handle NonDSC window value calculation and UI layout and logic
@@ -681,11 +1811,21 @@ void NonDSCCalculateAndShow(int index)
     else
         ImGui::Text("Unsaved.");
     ShowToolTip("You must type all data to save it into the PorchConf.txt file.");
+    if (isSave && !NonDSCDuplicateName[index].empty())
+        ImGui::TextColored(ImVec4(1.0f, 0.85f, 0.0f, 1.0f), "与已保存的配置 %s 数值相同", NonDSCDuplicateName[index].c_str());
+
+    std::string *inputs[] = {&NonDSCInputTxvid[index], &NonDSCInputHactive[index], &NonDSCInputVactive[index], &NonDSCInputHtotal[index], &NonDSCInputVtotal[index],
+                             &NonDSCInputAdjVactive[index], &NonDSCInputAdjHactive[index], &NonDSCInputHFP[index], &NonDSCInputHSYNC[index], &NonDSCInputHBP[index]};
+    ShowSimilarConfs(inputs);
+    ShowSweepControls(inputs, false);
+    ShowFeasibilityControls(inputs, false);
 }
 
 // save to porch file from DSC/NonDSC window
 bool SaveToPorchConfFile(bool isDSC, int index, float input[], float output[])
 {
+    trace::ScopedSpan span("save conf");
+    PollLibrarySave(true); // append after the background rewrite
     for (auto &it : InMemoryData)
     {
         if (it.porchName + " | DSC" == DSCWindowName[index] || it.porchName + " | NonDSC " == NonDSCWindowName[index])
@@ -725,7 +1865,7 @@ bool SaveToPorchConfFile(bool isDSC, int index, float input[], float output[])
     outStream.open(PorchConfFilePath, std::ofstream::out | std::ios::app); // append to the end of the file
     if (!outStream)
     {
-        std::cerr << "Error: Unable to open Porch Conf file!" << std::endl;
+        logger::Error("Unable to open Porch Conf file!");
         return false;
     }
 
@@ -763,100 +1903,228 @@ bool SaveToPorchConfFile(bool isDSC, int index, float input[], float output[])
     }
 
     outStream.close();
+    UpdatePorchIndex(); // index the appended record
+
+    // read the appended record back through the sidecar index instead of reloading the whole file
+    Conf conf;
+    if (InMemoryDataFileSize >= 0 &&
+        PorchIndex.size() == InMemoryData.size() + 1 &&
+        LoadPorchConfRecord(static_cast<int>(PorchIndex.size()) - 1, conf))
+    {
+        // flag a conf saved again under another name, the dedupe pass can merge them
+        int duplicate = InMemoryPayloadIndex.Find(InMemoryData, InMemoryRecordIds, conf);
+        (isDSC ? DSCDuplicateName : NonDSCDuplicateName)[index] = duplicate >= 0 ? InMemoryData[duplicate].porchName : "";
+
+        HistoryEdit edit;
+        edit.inserted.emplace_back(static_cast<uint32_t>(InMemoryData.size()), conf);
+        InsertInMemoryRecord(static_cast<uint32_t>(InMemoryData.size()), conf);
+        EditHistory.Push(std::move(edit));
+        MarkInMemoryDataLoaded();
+    }
     return true;
 }
 
 // save to porch file from delete event
 bool SaveToPorchConfFile()
 {
+    trace::ScopedSpan span("rewrite conf file");
+    PollLibrarySave(true);
     std::ofstream outStream;
-    outStream.open(PorchConfFilePath, std::ofstream::out); // overwrite the file
+    outStream.open(PorchConfFilePath, std::ios::out | std::ios::binary); // overwrite the file, binary mode keeps the indexed offsets exact
     if (!outStream)
     {
-        std::cerr << "Error: Unable to open Porch Conf file!" << std::endl;
+        logger::Error("Unable to open Porch Conf file!");
         return false;
     }
 
-    outStream << "PorchConfHeader@zionFisher //Do not delete this line or you will not be able to open this file" << std::endl;
+    outStream << PorchConfFileHeader << '\n';
 
+    // the sidecar index is built from the bytes written instead of scanning the file again
+    std::vector<PorchIndexEntry> index;
+    index.reserve(InMemoryData.size());
+    std::ostringstream recordStream;
+    uint64_t offset = PorchConfFileHeader.size() + 1;
     for (auto &it : InMemoryData)
-    {
-        // header
-        outStream << "0.  "
-                  << "============================================================" << std::endl
-                  << std::left;
-
-        outStream << "1.  " << std::setw(25) << (it.isDSC ? (it.porchName + " | DSC") : (it.porchName + " | NonDSC")) << "Porch Name" << std::endl;
-        outStream << "2.  " << std::setw(25) << (it.isDSC ? "DSC" : "NonDSC") << "Porch Type" << std::endl;
-        outStream << "3.  "
-                  << "---------------------------input----------------------------" << std::endl;
-        outStream << "4.  " << std::setw(15) << it.txvid << "txvid" << std::endl;
-        outStream << "5.  " << std::setw(15) << it.hactive << "hactive" << std::endl;
-        outStream << "6.  " << std::setw(15) << it.vactive << "vactive" << std::endl;
-        outStream << "7.  " << std::setw(15) << it.htotal << "htotal" << std::endl;
-        outStream << "8.  " << std::setw(15) << it.vtotal << "vtotal" << std::endl;
-        outStream << "9.  " << std::setw(15) << it.adjVactive << "adj_vactive" << std::endl;
-        outStream << "10. " << std::setw(15) << it.adjHactive << "adj_hactive" << std::endl;
-        outStream << "11. " << std::setw(15) << it.HFP << "HFP" << std::endl;
-        outStream << "12. " << std::setw(15) << it.HSYNC << "HSYNC" << std::endl;
-        outStream << "13. " << std::setw(15) << it.HBP << "HBP" << std::endl;
-        outStream << "14. "
-                  << "---------------------------output---------------------------" << std::endl;
-        outStream << "15. " << std::setw(15) << it.fps << "帧率" << std::endl;
-        outStream << "16. " << std::setw(15) << it.adjHtotal << "adj_htotal" << std::endl;
-        outStream << "17. " << std::setw(15) << it.adjHblank << "adj_hblank" << std::endl;
-        outStream << "18. " << std::setw(15) << it.minimumHline << "进 LP 时最小 HLINE" << std::endl;
-        outStream << "19. " << std::setw(15) << it.minimumLaneRateSwitchToLPMode << "切 LP mode, Lane 速率至少需要达到的值" << std::endl;
-
-        if (it.isDSC)
-        {
-            outStream << "20. " << std::setw(15) << it.adjHblankMinus40 << "adj_hblank - 40" << std::endl;
-            outStream << "21. " << std::setw(15) << it.hblankMinus40 << "hblank - 40" << std::endl;
-        }
-    }
+        WritePorchConfRecord(outStream, it, recordStream, offset, index);
 
     outStream.close();
-    LoadPorchConfFile();
+    MarkInMemoryDataLoaded(); // InMemoryData already holds what was written
+    SetPorchIndex(index);
     return true;
 }
 
-// load porch file
-bool LoadPorchConfFile()
+// inner function, read the whole Porch Conf file and check its header, bodyBegin is the offset of the first record
+static bool ReadPorchConfFileBuffer(std::string &fileBuf, size_t &bodyBegin)
 {
-    InMemoryData.clear(); // clear legacy data at very first
-
     std::ifstream inStream;
-    inStream.open(PorchConfFilePath, std::ofstream::in);
+    inStream.open(PorchConfFilePath, std::ios::in | std::ios::binary);
     if (!inStream)
     {
-        std::cerr << "Error: Unable to open Porch Conf file!" << std::endl;
+        logger::Error("Unable to open Porch Conf file!");
         return false;
     }
 
-    std::string lineBuf;
-    std::getline(inStream, lineBuf);
-    if (lineBuf != "PorchConfHeader@zionFisher //Do not delete this line or you will not be able to open this file")
+    inStream.seekg(0, std::ios::end);
+    fileBuf.assign(static_cast<size_t>(inStream.tellg()), '\0');
+    inStream.seekg(0, std::ios::beg);
+    inStream.read(&fileBuf[0], fileBuf.size());
+    inStream.close();
+
+    bodyBegin = fileBuf.find('\n');
+    bodyBegin = bodyBegin == std::string::npos ? fileBuf.size() : bodyBegin + 1;
+    std::string header = fileBuf.substr(0, bodyBegin);
+    while (!header.empty() && (header.back() == '\n' || header.back() == '\r'))
+        header.pop_back();
+    if (header != PorchConfFileHeader)
     {
-        std::cerr << "Error: The header is wrong, please change the first line of the file to \"PorchConfHeader@zionFisher //Do not delete this line or you will not be able to open this file]\"" << std::endl;
-        inStream.close();
+        logger::Error("The header is wrong, please change the first line of the file to \"PorchConfHeader@zionFisher //Do not delete this line or you will not be able to open this file]\"");
         return false;
     }
+    return true;
+}
 
-    while (std::getline(inStream, lineBuf))
+// load porch file
+bool LoadPorchConfFile()
+{
+    if (!PollLibrarySave(false))
+        return true; // InMemoryData is newer than the file being written
+    struct stat fileStat;
+    bool hasStat = stat(PorchConfFilePath.c_str(), &fileStat) == 0;
+    if (hasStat && static_cast<int64_t>(fileStat.st_size) == InMemoryDataFileSize && static_cast<int64_t>(fileStat.st_mtime) == InMemoryDataFileTime)
     {
-        if (!HandlePorchFileHeader(lineBuf))
+        if (!InMemoryDataIsRacy)
+            return true; // the file has not changed since it was loaded
+        if (utility::HashFileEnds(PorchConfFilePath) == InMemoryDataFileHash)
         {
-            inStream.close();
-            return false;
+            InMemoryDataIsRacy = InMemoryDataFileTime >= static_cast<int64_t>(std::time(nullptr)); // trusted once its second is over
+            return true;
         }
     }
+    if (hasStat && static_cast<int64_t>(fileStat.st_size) >= ParallelLoadMinFileSize)
+        return LoadPorchConfFileParallel(); // large library
 
-    inStream.close();
+    trace::ScopedSpan span("load conf file");
+
+    InMemoryData.clear(); // clear legacy data at very first
+    InMemoryDataFileSize = -1;
+    InMemoryDataLoadNum++;
+    DropLibraryEdits();   // library edits refer to the records being replaced
+
+    std::string fileBuf;
+    size_t bodyBegin = 0;
+    if (!ReadPorchConfFileBuffer(fileBuf, bodyBegin))
+        return false;
+
+    std::vector<PorchIndexEntry> index;
+    if (!ParsePorchConfChunk(fileBuf, bodyBegin, fileBuf.size(), InMemoryData, index))
+        return false;
+
+    MarkInMemoryDataLoaded();
+    BuildInMemoryIndexes();
+    SetPorchIndex(index); // the sidecar index comes from the parsed bytes, the file is not scanned again
+    return true;
+}
+
+
+// load porch file in parallel, chunks split at "0." lines are parsed on the thread pool and spliced in file order
+bool LoadPorchConfFileParallel()
+{
+    trace::ScopedSpan span("load conf file parallel");
+    InMemoryData.clear(); // clear legacy data at very first
+    InMemoryDataFileSize = -1;
+    InMemoryDataLoadNum++;
+    DropLibraryEdits();   // library edits refer to the records being replaced
+
+    std::string fileBuf;
+    size_t bodyBegin = 0;
+    if (!ReadPorchConfFileBuffer(fileBuf, bodyBegin))
+        return false;
+
+    // chunk boundaries, every chunk but the first starts at a "0." line
+    threadpool::ThreadPool &pool = threadpool::GlobalPool();
+    size_t chunkNum = pool.Size() * 4; // a few chunks per worker to even out the load
+    std::vector<size_t> bounds = {bodyBegin};
+    for (size_t i = 1; i < chunkNum; i++)
+    {
+        size_t pos = bodyBegin + (fileBuf.size() - bodyBegin) * i / chunkNum;
+        pos = fileBuf.find("\n0. ", std::max(pos, bounds.back()));
+        if (pos == std::string::npos)
+            break;
+        bounds.push_back(pos + 1);
+    }
+    bounds.push_back(fileBuf.size());
+
+    std::vector<std::vector<Conf>> chunkData(bounds.size() - 1);
+    std::vector<std::vector<PorchIndexEntry>> chunkIndex(bounds.size() - 1);
+    std::vector<char> chunkResult(bounds.size() - 1, 0);
+    pool.ParallelFor(0, chunkData.size(), 1, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++)
+            chunkResult[i] = ParsePorchConfChunk(fileBuf, bounds[i], bounds[i + 1], chunkData[i], chunkIndex[i]);
+    });
+
+    if (std::find(chunkResult.begin(), chunkResult.end(), 0) != chunkResult.end())
+        return false;
+
+    size_t total = 0;
+    for (auto &it : chunkData)
+        total += it.size();
+    InMemoryData.reserve(total);
+    for (auto &it : chunkData)
+        std::move(it.begin(), it.end(), std::back_inserter(InMemoryData));
+    std::vector<PorchIndexEntry> index;
+    index.reserve(total);
+    for (auto &it : chunkIndex) // a record never spans two chunks, entries hold file offsets
+        index.insert(index.end(), it.begin(), it.end());
+
+    MarkInMemoryDataLoaded();
+    BuildInMemoryIndexes();
+    SetPorchIndex(index); // the sidecar index comes from the parsed bytes, the file is not scanned again
+    return true;
+}
+
+// parse lines in [begin, end) of the file buffer, append parsed Conf into data and their sidecar index entries into index
+// entries are made the way ScanPorchConfFile makes them, from the raw bytes of each line
+bool ParsePorchConfChunk(const std::string &fileBuf, size_t begin, size_t end, std::vector<Conf> &data, std::vector<PorchIndexEntry> &index)
+{
+    trace::ScopedSpan span("parse conf chunk");
+    while (begin < end)
+    {
+        size_t lineEnd = fileBuf.find('\n', begin);
+        if (lineEnd == std::string::npos || lineEnd > end)
+            lineEnd = end;
+
+        size_t lineSize = lineEnd - begin;
+        if (lineSize > 0 && fileBuf[begin + lineSize - 1] == '\r')
+            lineSize--;
+
+        if (fileBuf.compare(begin, 3, "0. ") == 0)
+        {
+            PorchIndexEntry entry;
+            entry.offset = begin;
+            entry.checksum = utility::HashFNV1a32(nullptr, 0);
+            index.push_back(entry);
+        }
+        else if (fileBuf.compare(begin, 3, "1. ") == 0 && !index.empty())
+            index.back().nameHash = HashPorchNameWords(fileBuf.data() + begin + 2, fileBuf.data() + begin + lineSize);
+        if (!index.empty())
+            index.back().checksum = utility::HashFNV1a32(fileBuf.data() + begin, std::min(lineEnd + 1, end) - begin, index.back().checksum);
+
+        if (!HandlePorchFileHeader(fileBuf.substr(begin, lineSize), data))
+            return false;
+
+        begin = lineEnd + 1;
+    }
     return true;
 }
 
 // handle each line of the file
 bool HandlePorchFileHeader(std::string input)
+{
+    return HandlePorchFileHeader(input, InMemoryData);
+}
+
+// handle each line of the file, append parsed Conf into data
+bool HandlePorchFileHeader(std::string input, std::vector<Conf> &data)
 {
     std::istringstream strStream(input);
     std::string prefix;
@@ -864,125 +2132,141 @@ bool HandlePorchFileHeader(std::string input)
 
     if (prefix == "0.")
     {
-        InMemoryData.emplace_back(Conf());
+        data.emplace_back(Conf());
         return true;
     }
     if (prefix == "3." || prefix == "14.")
     {
         return true;
     }
+    if (data.empty()) // every record must start with a "0." line
+    {
+        logger::Error("incorrect porch file format");
+        return false;
+    }
     if (prefix == "1.")
     {
-        int separator = input.find_last_of('|');
-        std::string cur;
-        while (strStream >> prefix)
-        {
-            if (prefix == "|")
-                break;
-
-            cur += prefix;
-        };
-        InMemoryData.back().porchName = cur;
+        data.back().porchName = ParsePorchName(strStream);
         return true;
     }
     if (prefix == "2.")
     {
         strStream >> prefix;
-        InMemoryData.back().isDSC = prefix == "DSC" ? true : false;
+        data.back().isDSC = prefix == "DSC" ? true : false;
+        return true;
+    }
+    if (prefix == "22.")
+    {
+        data.back().aliases.push_back(ParsePorchName(strStream));
         return true;
     }
     float buf;
     strStream >> buf;
     if (prefix == "4.")
     {
-        InMemoryData.back().txvid = buf;
+        data.back().txvid = buf;
         return true;
     }
     if (prefix == "5.")
     {
-        InMemoryData.back().hactive = buf;
+        data.back().hactive = buf;
         return true;
     }
     if (prefix == "6.")
     {
-        InMemoryData.back().vactive = buf;
+        data.back().vactive = buf;
         return true;
     }
     if (prefix == "7.")
     {
-        InMemoryData.back().htotal = buf;
+        data.back().htotal = buf;
         return true;
     }
     if (prefix == "8.")
     {
-        InMemoryData.back().vtotal = buf;
+        data.back().vtotal = buf;
         return true;
     }
     if (prefix == "9.")
     {
-        InMemoryData.back().adjVactive = buf;
+        data.back().adjVactive = buf;
         return true;
     }
     if (prefix == "10.")
     {
-        InMemoryData.back().adjHactive = buf;
+        data.back().adjHactive = buf;
         return true;
     }
     if (prefix == "11.")
     {
-        InMemoryData.back().HFP = buf;
+        data.back().HFP = buf;
         return true;
     }
     if (prefix == "12.")
     {
-        InMemoryData.back().HSYNC = buf;
+        data.back().HSYNC = buf;
         return true;
     }
     if (prefix == "13.")
     {
-        InMemoryData.back().HBP = buf;
+        data.back().HBP = buf;
         return true;
     }
     if (prefix == "15.")
     {
-        InMemoryData.back().fps = buf;
+        data.back().fps = buf;
         return true;
     }
     if (prefix == "16.")
     {
-        InMemoryData.back().adjHtotal = buf;
+        data.back().adjHtotal = buf;
         return true;
     }
     if (prefix == "17.")
     {
-        InMemoryData.back().adjHblank = buf;
+        data.back().adjHblank = buf;
         return true;
     }
     if (prefix == "18.")
     {
-        InMemoryData.back().minimumHline = buf;
+        data.back().minimumHline = buf;
         return true;
     }
     if (prefix == "19.")
     {
-        InMemoryData.back().minimumLaneRateSwitchToLPMode = buf;
+        data.back().minimumLaneRateSwitchToLPMode = buf;
         return true;
     }
     if (prefix == "20.")
     {
-        InMemoryData.back().adjHblankMinus40 = buf;
+        data.back().adjHblankMinus40 = buf;
         return true;
     }
     if (prefix == "21.")
     {
-        InMemoryData.back().hblankMinus40 = buf;
+        data.back().hblankMinus40 = buf;
         return true;
     }
 
-    std::cerr << "Error: incorrect porch file format" << std::endl;
+    logger::Error("incorrect porch file format");
     return false;
 }
 
+// parse porch name from the rest of a "1." line, name ends before "|"
+std::string ParsePorchName(std::istringstream &strStream)
+{
+    std::string prefix;
+    std::string cur;
+    while (strStream >> prefix)
+    {
+        if (prefix == "|")
+            break;
+
+        cur += prefix;
+    };
+    return cur;
+}
+
 bool AddPage(bool isDSC, int index, float input[], float output[])
 {
     Conf *iterator = new Conf();
@@ -1000,7 +2284,3001 @@ bool AddPage(bool isDSC, int index, float input[], float output[])
 // delete specified entry in InMemoryData
 bool DeletePage(int index)
 {
-    InMemoryData.erase(InMemoryData.begin() + index);
+    if (index < 0 || index >= static_cast<int>(InMemoryData.size()))
+        return false;
+
+    HistoryEdit edit;
+    edit.erased.emplace_back(static_cast<uint32_t>(index), InMemoryData[index]);
+    EraseInMemoryRecord(static_cast<uint32_t>(index));
+    EditHistory.Push(std::move(edit));
 
     return SaveToPorchConfFile();
 }
+
+// validate the sidecar index against the Porch Conf file, rebuild it when stale
+bool UpdatePorchIndex()
+{
+    trace::ScopedSpan span("update porch index");
+    PollLibrarySave(true); // never scan a file being rewritten
+    struct stat fileStat;
+    if (stat(PorchConfFilePath.c_str(), &fileStat) != 0)
+        return false;
+
+    int64_t fileSize = static_cast<int64_t>(fileStat.st_size);
+    int64_t fileTime = static_cast<int64_t>(fileStat.st_mtime);
+    uint64_t fileHash = utility::HashFileEnds(PorchConfFilePath);
+    if (PorchIndexFileSize < 0)
+        LoadPorchIndexFile(); // first use, the sidecar file may be stale and is checked below
+
+    // an mtime in the current second may still change without moving, the last record is checked again then
+    bool isRacy = fileTime >= static_cast<int64_t>(std::time(nullptr));
+    if (fileSize == PorchIndexFileSize && fileTime == PorchIndexFileTime && fileHash == PorchIndexFileHash && !PorchIndex.empty())
+    {
+        if (!isRacy)
+            return true; // index is up to date
+        PorchIndexEntry last = PorchIndex.back();
+        PorchIndex.pop_back();
+        if (ScanPorchConfFile(last.offset, static_cast<uint64_t>(fileSize)) &&
+            PorchIndex.size() > 0 &&
+            PorchIndex.back().offset == last.offset &&
+            PorchIndex.back().checksum == last.checksum)
+            return true;
+    }
+
+    // the file only grew: keep the old entries and scan the appended bytes
+    if (!PorchIndex.empty() && PorchIndexFileSize > 0 && fileSize > PorchIndexFileSize)
+    {
+        PorchIndexEntry last = PorchIndex.back();
+        PorchIndex.pop_back();
+        uint64_t lastEnd = static_cast<uint64_t>(PorchIndexFileSize);
+        if (ScanPorchConfFile(last.offset, lastEnd) &&
+            PorchIndex.size() > 0 &&
+            PorchIndex.back().offset == last.offset &&
+            PorchIndex.back().checksum == last.checksum &&
+            ScanPorchConfFile(lastEnd, static_cast<uint64_t>(fileSize)))
+        {
+            PorchIndexFileSize = fileSize;
+            PorchIndexFileTime = fileTime;
+            PorchIndexFileHash = fileHash;
+            SavePorchIndexFile();
+            return true;
+        }
+    }
+
+    // full rebuild
+    PorchIndex.clear();
+    PorchIndexFileSize = -1;
+    PorchIndexFileTime = -1;
+    if (!ScanPorchConfFile(0, static_cast<uint64_t>(fileSize)))
+    {
+        PorchIndex.clear();
+        return false;
+    }
+
+    PorchIndexFileSize = fileSize;
+    PorchIndexFileTime = fileTime;
+    PorchIndexFileHash = fileHash;
+    SavePorchIndexFile();
+    return true;
+}
+
+// load sidecar index file with the size, modification time and ends hash it was built for
+bool LoadPorchIndexFile()
+{
+    std::ifstream inStream;
+    inStream.open(PorchIndexFilePath, std::ios::in | std::ios::binary);
+    if (!inStream)
+        return false;
+
+    char magic[4] = {};
+    uint32_t version = 0;
+    int64_t indexFileSize = -1, indexFileTime = -1;
+    uint64_t indexFileHash = 0;
+    uint64_t count = 0;
+    inStream.read(magic, sizeof(magic));
+    inStream.read(reinterpret_cast<char *>(&version), sizeof(version));
+    inStream.read(reinterpret_cast<char *>(&indexFileSize), sizeof(indexFileSize));
+    inStream.read(reinterpret_cast<char *>(&indexFileTime), sizeof(indexFileTime));
+    inStream.read(reinterpret_cast<char *>(&indexFileHash), sizeof(indexFileHash));
+    inStream.read(reinterpret_cast<char *>(&count), sizeof(count));
+    if (!inStream ||
+        !std::equal(magic, magic + 4, PorchIndexMagic) ||
+        version != PorchIndexVersion ||
+        indexFileSize < 0 ||
+        count > static_cast<uint64_t>(indexFileSize))
+        return false;
+
+    std::vector<PorchIndexEntry> index(count);
+    for (auto &it : index)
+    {
+        inStream.read(reinterpret_cast<char *>(&it.offset), sizeof(it.offset));
+        inStream.read(reinterpret_cast<char *>(&it.nameHash), sizeof(it.nameHash));
+        inStream.read(reinterpret_cast<char *>(&it.checksum), sizeof(it.checksum));
+    }
+    if (!inStream)
+        return false;
+
+    PorchIndex.swap(index);
+    PorchIndexFileSize = indexFileSize;
+    PorchIndexFileTime = indexFileTime;
+    PorchIndexFileHash = indexFileHash;
+    return true;
+}
+
+// save in memory index to the sidecar index file
+bool SavePorchIndexFile()
+{
+    std::ofstream outStream;
+    outStream.open(PorchIndexFilePath, std::ios::out | std::ios::binary); // overwrite the file
+    if (!outStream)
+        return false;
+
+    uint64_t count = PorchIndex.size();
+    outStream.write(PorchIndexMagic, sizeof(PorchIndexMagic));
+    outStream.write(reinterpret_cast<const char *>(&PorchIndexVersion), sizeof(PorchIndexVersion));
+    outStream.write(reinterpret_cast<const char *>(&PorchIndexFileSize), sizeof(PorchIndexFileSize));
+    outStream.write(reinterpret_cast<const char *>(&PorchIndexFileTime), sizeof(PorchIndexFileTime));
+    outStream.write(reinterpret_cast<const char *>(&PorchIndexFileHash), sizeof(PorchIndexFileHash));
+    outStream.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    for (auto &it : PorchIndex)
+    {
+        outStream.write(reinterpret_cast<const char *>(&it.offset), sizeof(it.offset));
+        outStream.write(reinterpret_cast<const char *>(&it.nameHash), sizeof(it.nameHash));
+        outStream.write(reinterpret_cast<const char *>(&it.checksum), sizeof(it.checksum));
+    }
+
+    outStream.close();
+    return static_cast<bool>(outStream);
+}
+
+// scan bytes [from, to) of the Porch Conf file and append one index entry per "0." record
+bool ScanPorchConfFile(uint64_t from, uint64_t to)
+{
+    std::ifstream inStream;
+    inStream.open(PorchConfFilePath, std::ios::in | std::ios::binary); // binary mode keeps byte offsets exact
+    if (!inStream)
+        return false;
+
+    inStream.seekg(static_cast<std::streamoff>(from));
+    uint64_t offset = from;
+    std::string lineBuf;
+    while (offset < to && std::getline(inStream, lineBuf))
+    {
+        uint64_t lineSize = lineBuf.size() + (inStream.eof() ? 0 : 1);
+        if (from == 0 && offset == 0) // skip file header
+        {
+            offset += lineSize;
+            continue;
+        }
+
+        if (lineBuf.compare(0, 3, "0. ") == 0)
+        {
+            PorchIndexEntry entry;
+            entry.offset = offset;
+            entry.checksum = utility::HashFNV1a32(nullptr, 0);
+            PorchIndex.push_back(entry);
+        }
+        else if (lineBuf.compare(0, 3, "1. ") == 0 && !PorchIndex.empty())
+            PorchIndex.back().nameHash = HashPorchNameWords(lineBuf.data() + 2, lineBuf.data() + lineBuf.size());
+
+        if (PorchIndex.empty())
+            return false; // data before the first "0." line
+
+        PorchIndex.back().checksum = utility::HashFNV1a32(lineBuf.data(), lineBuf.size(), PorchIndex.back().checksum);
+        if (lineSize > lineBuf.size())
+            PorchIndex.back().checksum = utility::HashFNV1a32("\n", 1, PorchIndex.back().checksum);
+
+        offset += lineSize;
+    }
+
+    return true;
+}
+
+// inner function, read the record starting at offset, the caller has checked the offset against a valid sidecar index
+static bool ReadPorchConfRecordAt(std::istream &inStream, uint64_t offset, Conf &conf)
+{
+    inStream.clear(); // the previous record may have been read up to the end of the file
+    inStream.seekg(static_cast<std::streamoff>(offset));
+
+    std::vector<Conf> data;
+    std::string lineBuf;
+    while (std::getline(inStream, lineBuf))
+    {
+        if (!data.empty() && lineBuf.compare(0, 3, "0. ") == 0)
+            break; // next record
+
+        if (!HandlePorchFileHeader(lineBuf, data))
+            return false;
+    }
+
+    if (data.empty())
+        return false;
+
+    conf = data.back();
+    return true;
+}
+
+// install the sidecar index built while InMemoryData was loaded or written, falls back to a scan when it does not match
+void SetPorchIndex(std::vector<PorchIndexEntry> &index)
+{
+    if (InMemoryDataFileSize < 0 || index.size() != InMemoryData.size())
+    {
+        UpdatePorchIndex();
+        return;
+    }
+
+    PorchIndex.swap(index);
+    PorchIndexFileSize = InMemoryDataFileSize;
+    PorchIndexFileTime = InMemoryDataFileTime;
+    PorchIndexFileHash = InMemoryDataFileHash;
+    SavePorchIndexFile();
+}
+
+// hash of the name ParsePorchName reads from [first, last): the words up to a lone "|", joined without spaces
+uint64_t HashPorchNameWords(const char *first, const char *last)
+{
+    std::string name;
+    while (first != last)
+    {
+        while (first != last && std::isspace(static_cast<unsigned char>(*first)))
+            first++;
+        const char *wordEnd = first;
+        while (wordEnd != last && !std::isspace(static_cast<unsigned char>(*wordEnd)))
+            wordEnd++;
+        if (wordEnd - first == 1 && *first == '|')
+            break;
+        name.append(first, wordEnd);
+        first = wordEnd;
+    }
+    return utility::HashFNV1a64(name.data(), name.size());
+}
+
+// random access to the record at index without parsing the records before it
+bool LoadPorchConfRecord(int index, Conf &conf)
+{
+    if (!UpdatePorchIndex() || index < 0 || index >= static_cast<int>(PorchIndex.size()))
+        return false;
+
+    std::ifstream inStream;
+    inStream.open(PorchConfFilePath, std::ios::in | std::ios::binary);
+    if (!inStream)
+        return false;
+
+    return ReadPorchConfRecordAt(inStream, PorchIndex[index].offset, conf);
+}
+
+// find record index by porch name through the sidecar index, -1 if not found
+// the index is validated and the file opened once, each name hash match costs one seek
+int FindPorchConfRecord(const std::string &porchName)
+{
+    if (!UpdatePorchIndex())
+        return -1;
+
+    std::ifstream inStream;
+    uint64_t nameHash = utility::HashFNV1a64(porchName.data(), porchName.size());
+    for (int i = 0; i < static_cast<int>(PorchIndex.size()); i++)
+    {
+        if (PorchIndex[i].nameHash != nameHash)
+            continue;
+        if (!inStream.is_open())
+        {
+            inStream.open(PorchConfFilePath, std::ios::in | std::ios::binary);
+            if (!inStream)
+                return -1;
+        }
+
+        Conf conf;
+        if (ReadPorchConfRecordAt(inStream, PorchIndex[i].offset, conf) && conf.porchName == porchName)
+            return i;
+    }
+
+    return -1;
+}
+
+// write one record in the Porch Conf file format
+void WritePorchConfRecord(std::ostream &outStream, const Conf &conf)
+{
+    // header
+    outStream << "0.  "
+              << "============================================================" << '\n'
+              << std::left; // '\n' instead of std::endl, large files must not flush on every line
+
+    outStream << "1.  " << std::setw(25) << (conf.isDSC ? (conf.porchName + " | DSC") : (conf.porchName + " | NonDSC")) << "Porch Name" << '\n';
+    outStream << "2.  " << std::setw(25) << (conf.isDSC ? "DSC" : "NonDSC") << "Porch Type" << '\n';
+    outStream << "3.  "
+              << "---------------------------input----------------------------" << '\n';
+    outStream << "4.  " << std::setw(15) << conf.txvid << "txvid" << '\n';
+    outStream << "5.  " << std::setw(15) << conf.hactive << "hactive" << '\n';
+    outStream << "6.  " << std::setw(15) << conf.vactive << "vactive" << '\n';
+    outStream << "7.  " << std::setw(15) << conf.htotal << "htotal" << '\n';
+    outStream << "8.  " << std::setw(15) << conf.vtotal << "vtotal" << '\n';
+    outStream << "9.  " << std::setw(15) << conf.adjVactive << "adj_vactive" << '\n';
+    outStream << "10. " << std::setw(15) << conf.adjHactive << "adj_hactive" << '\n';
+    outStream << "11. " << std::setw(15) << conf.HFP << "HFP" << '\n';
+    outStream << "12. " << std::setw(15) << conf.HSYNC << "HSYNC" << '\n';
+    outStream << "13. " << std::setw(15) << conf.HBP << "HBP" << '\n';
+    outStream << "14. "
+              << "---------------------------output---------------------------" << '\n';
+    outStream << "15. " << std::setw(15) << conf.fps << "帧率" << '\n';
+    outStream << "16. " << std::setw(15) << conf.adjHtotal << "adj_htotal" << '\n';
+    outStream << "17. " << std::setw(15) << conf.adjHblank << "adj_hblank" << '\n';
+    outStream << "18. " << std::setw(15) << conf.minimumHline << "进 LP 时最小 HLINE" << '\n';
+    outStream << "19. " << std::setw(15) << conf.minimumLaneRateSwitchToLPMode << "切 LP mode, Lane 速率至少需要达到的值" << '\n';
+
+    if (conf.isDSC)
+    {
+        outStream << "20. " << std::setw(15) << conf.adjHblankMinus40 << "adj_hblank - 40" << '\n';
+        outStream << "21. " << std::setw(15) << conf.hblankMinus40 << "hblank - 40" << '\n';
+    }
+
+    for (auto &it : conf.aliases)
+        outStream << "22. " << std::setw(25) << (it + " | Alias") << "Porch Alias" << '\n';
+}
+
+// write one record and append its sidecar index entry, offset is the record's position in the file and moves past it
+void WritePorchConfRecord(std::ostream &outStream, const Conf &conf, std::ostringstream &recordStream, uint64_t &offset, std::vector<PorchIndexEntry> &index)
+{
+    recordStream.str(std::string());
+    WritePorchConfRecord(recordStream, conf);
+    const std::string record = recordStream.str();
+
+    PorchIndexEntry entry;
+    entry.offset = offset;
+    entry.checksum = utility::HashFNV1a32(record.data(), record.size());
+    size_t nameLine = record.find('\n') + 1; // the "1." line follows the "0." line
+    entry.nameHash = HashPorchNameWords(record.data() + nameLine + 2, record.data() + record.find('\n', nameLine));
+    index.push_back(entry);
+
+    outStream.write(record.data(), static_cast<std::streamsize>(record.size()));
+    offset += record.size();
+}
+
+// recompute output data of conf from its input data, same formulas as the DSC/NonDSC windows
+void RecomputeConf(Conf &conf)
+{
+    conf.adjHtotal = (conf.vactive) * (conf.htotal) / (conf.adjVactive);
+    conf.adjHblank = conf.adjHtotal - conf.adjHactive;
+    conf.minimumHline = std::ceil((static_cast<float>(4 * 50 + 4 * 96 + 4 * 40 + 14 + 3 * (conf.adjHactive) + 4 * (conf.HSYNC) + 4 * (conf.HBP))) / (3.0f));
+    conf.minimumLaneRateSwitchToLPMode = utility::ceiling((((conf.adjHactive) * 3.0f / 4.0f + (conf.HFP) + (conf.HSYNC) + (conf.HBP)) * ((conf.txvid) / conf.adjHtotal)) * 8.0f * 1.2f, 25);
+
+    if (conf.isDSC)
+    {
+        conf.fps = (conf.txvid * 1000000.0f) / (conf.adjHtotal * (((conf.vtotal) - (conf.vactive)) + (conf.adjVactive)));
+        conf.adjHblankMinus40 = conf.adjHblank - 40;
+        conf.hblankMinus40 = (conf.htotal) - 40 - (conf.hactive);
+    }
+    else
+    {
+        conf.fps = (conf.txvid * 1000000.0f) / (conf.htotal * conf.vtotal);
+        conf.adjHblankMinus40 = -2;
+        conf.hblankMinus40 = -2;
+    }
+}
+
+// check conf inputs and that its stored outputs match the recomputed ones
+bool ValidateConf(const Conf &conf, std::string &message)
+{
+    if (conf.porchName.empty())
+    {
+        message = "empty porch name";
+        return false;
+    }
+
+    if (!(conf.txvid > 0 && conf.hactive > 0 && conf.vactive > 0 && conf.htotal > 0 && conf.vtotal > 0 &&
+          conf.adjVactive > 0 && conf.adjHactive > 0 && conf.HFP >= 0 && conf.HSYNC >= 0 && conf.HBP >= 0))
+    {
+        message = "missing or non-positive input data";
+        return false;
+    }
+
+    Conf recomputed = conf;
+    RecomputeConf(recomputed);
+
+    // the file stores 6 significant digits
+    auto same = [](float stored, float expected) { return std::fabs(stored - expected) <= 1e-3f + 1e-5f * std::fabs(expected); };
+    const char *mismatch = nullptr;
+    if (!same(conf.fps, recomputed.fps))
+        mismatch = "帧率";
+    else if (!same(conf.adjHtotal, recomputed.adjHtotal))
+        mismatch = "adj_htotal";
+    else if (!same(conf.adjHblank, recomputed.adjHblank))
+        mismatch = "adj_hblank";
+    else if (!same(conf.minimumHline, recomputed.minimumHline))
+        mismatch = "进 LP 时最小 HLINE";
+    else if (!same(conf.minimumLaneRateSwitchToLPMode, recomputed.minimumLaneRateSwitchToLPMode))
+        mismatch = "切 LP mode, Lane 速率至少需要达到的值";
+    else if (conf.isDSC && !same(conf.adjHblankMinus40, recomputed.adjHblankMinus40))
+        mismatch = "adj_hblank - 40";
+    else if (conf.isDSC && !same(conf.hblankMinus40, recomputed.hblankMinus40))
+        mismatch = "hblank - 40";
+
+    if (mismatch != nullptr)
+    {
+        message = std::string("stored output does not match input: ") + mismatch;
+        return false;
+    }
+
+    return true;
+}
+
+// open the file and check its header line
+PorchConfReader::PorchConfReader(const std::string &filePath)
+{
+    inStream.open(filePath, std::ios::in | std::ios::binary);
+    if (!inStream)
+    {
+        logger::Error("Unable to open Porch Conf file!");
+        hasError = true;
+        return;
+    }
+
+    std::getline(inStream, lineBuf);
+    if (!lineBuf.empty() && lineBuf.back() == '\r')
+        lineBuf.pop_back();
+    if (lineBuf != PorchConfFileHeader)
+    {
+        logger::Error("The header is wrong, please change the first line of the file to \"PorchConfHeader@zionFisher //Do not delete this line or you will not be able to open this file]\"");
+        hasError = true;
+        return;
+    }
+
+    isOpen = true;
+}
+
+// a record is complete when the next "0." line or the end of the file is reached
+bool PorchConfReader::Next(Conf &conf)
+{
+    if (!isOpen || hasError)
+        return false;
+
+    while (std::getline(inStream, lineBuf))
+    {
+        if (!lineBuf.empty() && lineBuf.back() == '\r')
+            lineBuf.pop_back();
+
+        bool isNextRecord = lineBuf.compare(0, 3, "0. ") == 0 && !pending.empty();
+        if (isNextRecord)
+        {
+            conf = std::move(pending.back());
+            pending.clear();
+        }
+
+        if (!HandlePorchFileHeader(lineBuf, pending))
+        {
+            hasError = true;
+            return false;
+        }
+
+        if (isNextRecord)
+            return true;
+    }
+
+    if (pending.empty())
+        return false;
+
+    conf = std::move(pending.back());
+    pending.clear();
+    return true;
+}
+
+// command line entrance, runs without creating a window
+int RunCommandLine(int argc, char *argv[])
+{
+    std::string command = argv[1];
+    if (command != "record") // the console is the only output of a command, none of its lines is rate limited
+        logger::GlobalLogger().SetConsoleUnlimited(true);
+    if (command == "validate" && argc == 3)
+        return RunValidateCommand(argv[2]);
+    if (command == "pipeline" && argc >= 4)
+        return RunPipelineCommand(argc, argv);
+    if (command == "export" && argc == 4)
+        return RunExportCommand(argv[2], argv[3]);
+    if (command == "import" && argc == 4)
+        return RunImportCommand(argv[2], argv[3]);
+    if (command == "query" && argc == 4)
+        return RunQueryCommand(argv[2], argv[3]);
+    if (command == "dedupe" && argc == 4)
+        return RunDedupeCommand(argv[2], argv[3]);
+    if (command == "archive" && argc == 4)
+        return RunArchiveCommand(argv[2], argv[3]);
+    if (command == "extract" && argc == 4)
+        return RunExtractCommand(argv[2], argv[3]);
+    if (command == "bench")
+        return RunBenchCommand(argc, argv);
+    if (command == "record" && argc == 3)
+        return RunWindow(argv[2]);
+    if (command == "replay" && argc >= 3)
+        return RunReplayCommand(argc, argv);
+
+    PrintCommandLineUsage();
+    return 2;
+}
+
+// validate every record of a conf file, one record in memory at a time
+int RunValidateCommand(const std::string &inPath)
+{
+    PorchConfReader reader(inPath);
+    if (!reader.IsOpen())
+        return 1;
+
+    Conf conf;
+    std::string message;
+    uint64_t recordNum = 0, invalidNum = 0;
+    while (reader.Next(conf))
+    {
+        if (!ValidateConf(conf, message))
+        {
+            std::cout << "record " << recordNum << " (" << conf.porchName << "): " << message << '\n';
+            invalidNum++;
+        }
+        recordNum++;
+    }
+
+    std::cout << recordNum << " records, " << invalidNum << " invalid" << std::endl;
+    return (reader.HasError() || invalidNum > 0) ? 1 : 0;
+}
+
+// stream records through filter -> recompute -> validate stages into the output file
+int RunPipelineCommand(int argc, char *argv[])
+{
+    std::string inPath = argv[2];
+    std::string outPath = argv[3];
+    std::string nameFilter;
+    int typeFilter = -1; // -1: any, 0: NonDSC, 1: DSC
+    bool recompute = false;
+    bool validOnly = false;
+    std::vector<RangeQueryTerm> rangeQuery;
+    std::string message;
+
+    for (int i = 4; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--name") == 0 && i + 1 < argc)
+            nameFilter = argv[++i];
+        else if (std::strcmp(argv[i], "--type") == 0 && i + 1 < argc)
+        {
+            std::string type = argv[++i];
+            if (type != "DSC" && type != "NonDSC")
+            {
+                PrintCommandLineUsage();
+                return 2;
+            }
+            typeFilter = type == "DSC" ? 1 : 0;
+        }
+        else if (std::strcmp(argv[i], "--where") == 0 && i + 1 < argc)
+        {
+            if (!ParseRangeQuery(argv[++i], rangeQuery, message))
+            {
+                logger::Error(message);
+                return 2;
+            }
+        }
+        else if (std::strcmp(argv[i], "--recompute") == 0)
+            recompute = true;
+        else if (std::strcmp(argv[i], "--valid-only") == 0)
+            validOnly = true;
+        else
+        {
+            PrintCommandLineUsage();
+            return 2;
+        }
+    }
+
+    // input and output may be Porch Conf files or CSV/JSON Lines tables
+    std::unique_ptr<PorchConfReader> confReader;
+    std::unique_ptr<ConfTableReader> tableReader;
+    if (GetConfTableFormat(inPath) == ConfTableFormat::Unknown)
+        confReader.reset(new PorchConfReader(inPath));
+    else
+        tableReader.reset(new ConfTableReader(inPath));
+    if (confReader ? !confReader->IsOpen() : !tableReader->IsOpen())
+        return 1;
+
+    std::unique_ptr<std::ofstream> confWriter;
+    std::unique_ptr<ConfTableWriter> tableWriter;
+    if (GetConfTableFormat(outPath) == ConfTableFormat::Unknown)
+    {
+        confWriter.reset(new std::ofstream(outPath, std::ofstream::out)); // overwrite the file
+        *confWriter << PorchConfFileHeader << '\n';
+    }
+    else
+        tableWriter.reset(new ConfTableWriter(outPath));
+    if (confWriter ? !*confWriter : !tableWriter->IsOpen())
+    {
+        logger::Error("Unable to open output file!");
+        return 1;
+    }
+
+    Conf conf;
+    uint64_t readNum = 0, writeNum = 0;
+    while (confReader ? confReader->Next(conf) : tableReader->Next(conf))
+    {
+        readNum++;
+        if (!nameFilter.empty() && conf.porchName.find(nameFilter) == std::string::npos)
+            continue;
+        if (typeFilter >= 0 && conf.isDSC != (typeFilter == 1))
+            continue;
+        if (!MatchRangeQuery(conf, rangeQuery))
+            continue;
+        if (recompute)
+            RecomputeConf(conf);
+        if (validOnly && !ValidateConf(conf, message))
+            continue;
+
+        if (confWriter)
+            WritePorchConfRecord(*confWriter, conf);
+        else
+            tableWriter->Write(conf);
+        writeNum++;
+    }
+
+    bool writeOk = true;
+    if (confWriter)
+    {
+        confWriter->close();
+        writeOk = static_cast<bool>(*confWriter);
+    }
+    else
+        writeOk = tableWriter->Close();
+
+    bool readError = confReader ? confReader->HasError() : tableReader->HasError();
+    std::cout << readNum << " records read, " << writeNum << " records written" << std::endl;
+    return (readError || !writeOk) ? 1 : 0;
+}
+
+void PrintCommandLineUsage()
+{
+    std::cout << "usage:\n"
+              << "  main validate <conf file>\n"
+              << "  main pipeline <input file> <output file> [--name <text>] [--type DSC|NonDSC] [--where <query>] [--recompute] [--valid-only]\n"
+              << "  main export <conf file> <table file>\n"
+              << "  main import <table file> <conf file>\n"
+              << "  main query <conf file> <query>\n"
+              << "  main dedupe <conf file> <output conf file>\n"
+              << "  main archive <conf file> <archive file>\n"
+              << "  main extract <archive file> <conf file>\n"
+              << "  main bench [--conf <conf file>] [--records <n>] [--frames <n>] [--windows <n>] [--csv <file>] [--max-ms <ms>]\n"
+              << "  main record <input file>\n"
+              << "  main replay <input file> [--conf <conf file>] [--csv <file>] [--max-ms <ms>]\n"
+              << "table files end with .csv or .jsonl, pipeline input and output may be conf or table files\n"
+              << "query terms are separated by spaces: field=lower..upper, field=lower.., field=..upper or field=value\n"
+              << "for example: \"fps=59.9..60.1 minimum_lane_rate=..1000 hactive=1080\"\n";
+}
+
+// export every record of a conf file to CSV/JSON Lines, one record in memory at a time
+int RunExportCommand(const std::string &inPath, const std::string &outPath)
+{
+    if (GetConfTableFormat(outPath) == ConfTableFormat::Unknown)
+    {
+        PrintCommandLineUsage();
+        return 2;
+    }
+
+    return ExportConfTable(inPath, outPath) ? 0 : 1;
+}
+
+// convert a CSV/JSON Lines table to a conf file, rows are read in batches
+int RunImportCommand(const std::string &inPath, const std::string &outPath)
+{
+    if (GetConfTableFormat(inPath) == ConfTableFormat::Unknown)
+    {
+        PrintCommandLineUsage();
+        return 2;
+    }
+
+    ConfTableReader reader(inPath);
+    if (!reader.IsOpen())
+        return 1;
+
+    std::ofstream outStream;
+    outStream.open(outPath, std::ofstream::out); // overwrite the file
+    if (!outStream)
+    {
+        logger::Error("Unable to open output file!");
+        return 1;
+    }
+    outStream << PorchConfFileHeader << '\n';
+
+    ConfBatch batch;
+    uint64_t recordNum = 0;
+    while (reader.ReadBatch(batch, 4096) > 0)
+    {
+        for (size_t i = 0; i < batch.Size(); i++)
+            WritePorchConfRecord(outStream, batch.Get(i));
+        recordNum += batch.Size();
+        batch.Clear();
+    }
+
+    outStream.close();
+    std::cout << recordNum << " records imported" << std::endl;
+    return (reader.HasError() || !outStream) ? 1 : 0;
+}
+
+// table format from the file extension
+ConfTableFormat GetConfTableFormat(const std::string &filePath)
+{
+    auto endsWith = [&filePath](const char *suffix) {
+        size_t size = std::strlen(suffix);
+        return filePath.size() >= size && filePath.compare(filePath.size() - size, size, suffix) == 0;
+    };
+
+    if (endsWith(".csv"))
+        return ConfTableFormat::CSV;
+    if (endsWith(".jsonl"))
+        return ConfTableFormat::JSONL;
+    return ConfTableFormat::Unknown;
+}
+
+// stream a conf file into a CSV/JSON Lines table
+bool ExportConfTable(const std::string &inPath, const std::string &outPath)
+{
+    trace::ScopedSpan span("export conf table");
+    PollLibrarySave(true);
+    PorchConfReader reader(inPath);
+    if (!reader.IsOpen())
+        return false;
+
+    ConfTableWriter writer(outPath);
+    if (!writer.IsOpen())
+    {
+        logger::Error("Unable to open output file!");
+        return false;
+    }
+
+    Conf conf;
+    while (reader.Next(conf))
+        writer.Write(conf);
+
+    return writer.Close() && !reader.HasError();
+}
+
+// append the rows of a CSV/JSON Lines table to the library, rows whose name already exists are skipped
+bool ImportConfTable(const std::string &inPath)
+{
+    trace::ScopedSpan span("import conf table");
+    if (!LoadPorchConfFile())
+        return false;
+
+    ConfTableReader reader(inPath);
+    if (!reader.IsOpen())
+        return false;
+
+    std::unordered_set<std::string> porchNames;
+    for (auto &it : InMemoryData)
+        porchNames.insert(it.porchName);
+    size_t oldSize = InMemoryData.size();
+
+    ConfBatch batch;
+    while (reader.ReadBatch(batch, 4096) > 0)
+    {
+        for (size_t i = 0; i < batch.Size(); i++)
+        {
+            if (porchNames.insert(batch.porchName[i]).second)
+                InMemoryData.push_back(batch.Get(i));
+        }
+        batch.Clear();
+    }
+
+    if (reader.HasError())
+        return false;
+
+    // reload so imported names are normalized the same way as names read from the file
+    // the records before the import are unchanged, so the history stays valid
+    bool isSaved = SaveToPorchConfFile();
+    undohistory::UndoHistory<HistoryEdit> history = std::move(EditHistory);
+    InMemoryDataFileSize = -1;
+    bool isLoaded = LoadPorchConfFile();
+    EditHistory = std::move(history);
+    if (!isLoaded)
+    {
+        DropLibraryEdits(); // InMemoryData is gone, input edits stay
+        return false;
+    }
+
+    HistoryEdit edit;
+    for (size_t i = oldSize; i < InMemoryData.size(); i++)
+        edit.inserted.emplace_back(static_cast<uint32_t>(i), InMemoryData[i]);
+    if (!edit.inserted.empty())
+        EditHistory.Push(std::move(edit));
+    return isSaved;
+}
+
+// split one CSV line into fields, quoted fields may contain commas and doubled quotes
+bool ParseCsvLine(const std::string &line, std::vector<std::string> &fields)
+{
+    size_t fieldNum = 0;
+    size_t pos = 0;
+    while (true)
+    {
+        if (fieldNum == fields.size())
+            fields.emplace_back();
+        std::string &field = fields[fieldNum++];
+        field.clear();
+
+        if (pos < line.size() && line[pos] == '"')
+        {
+            pos++;
+            while (true)
+            {
+                size_t quote = line.find('"', pos);
+                if (quote == std::string::npos)
+                    return false; // unterminated quote
+
+                field.append(line, pos, quote - pos);
+                pos = quote + 1;
+                if (pos < line.size() && line[pos] == '"')
+                {
+                    field += '"';
+                    pos++;
+                    continue;
+                }
+                break;
+            }
+            if (pos < line.size() && line[pos] != ',')
+                return false;
+        }
+        else
+        {
+            size_t comma = line.find(',', pos);
+            field.append(line, pos, (comma == std::string::npos ? line.size() : comma) - pos);
+            pos = comma == std::string::npos ? line.size() : comma;
+        }
+
+        if (pos >= line.size())
+            break;
+        pos++; // skip ','
+    }
+
+    fields.resize(fieldNum);
+    return true;
+}
+
+// true when record ends inside a quoted field, a quote opens a field or doubles the quote that just closed
+bool IsCsvRecordOpen(const std::string &record)
+{
+    bool isQuoted = false;
+    bool isQuoteAllowed = true;
+    for (char ch : record)
+    {
+        if (isQuoted)
+        {
+            isQuoted = ch != '"';
+            isQuoteAllowed = !isQuoted;
+            continue;
+        }
+        isQuoted = ch == '"' && isQuoteAllowed;
+        isQuoteAllowed = ch == ',';
+    }
+    return isQuoted;
+}
+
+// parse one flat JSON object, string values are unescaped, other values are kept as text and null becomes empty
+bool ParseJsonLine(const std::string &line, std::vector<std::pair<std::string, std::string>> &members)
+{
+    members.clear();
+    size_t pos = 0;
+    auto skipSpace = [&]() {
+        while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t'))
+            pos++;
+    };
+    auto parseString = [&](std::string &out) {
+        out.clear();
+        if (pos >= line.size() || line[pos] != '"')
+            return false;
+        pos++;
+        while (pos < line.size() && line[pos] != '"')
+        {
+            char ch = line[pos++];
+            if (ch != '\\')
+            {
+                out += ch;
+                continue;
+            }
+            if (pos >= line.size())
+                return false;
+            ch = line[pos++];
+            switch (ch)
+            {
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u':
+            {
+                auto parseHex = [&](uint32_t &code) {
+                    if (pos + 4 > line.size())
+                        return false;
+                    code = 0;
+                    for (size_t end = pos + 4; pos < end; pos++) // exactly four hex digits, no sign or space
+                    {
+                        char digit = line[pos];
+                        if (!std::isxdigit(static_cast<unsigned char>(digit)))
+                            return false;
+                        code = code << 4 | static_cast<uint32_t>(std::isdigit(static_cast<unsigned char>(digit)) ? digit - '0' : std::tolower(static_cast<unsigned char>(digit)) - 'a' + 10);
+                    }
+                    return true;
+                };
+                uint32_t code = 0;
+                if (!parseHex(code))
+                    return false;
+                if (code >= 0xD800 && code < 0xDC00) // high surrogate, only valid as the first half of a pair
+                {
+                    if (line.compare(pos, 2, "\\u") != 0)
+                        return false;
+                    pos += 2;
+                    uint32_t low = 0;
+                    if (!parseHex(low) || low < 0xDC00 || low > 0xDFFF)
+                        return false;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                else if (code >= 0xDC00 && code <= 0xDFFF) // lone low surrogate, no UTF-8 encoding exists
+                    return false;
+                // UTF-8 encode
+                if (code < 0x80)
+                    out += static_cast<char>(code);
+                else if (code < 0x800)
+                {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else if (code < 0x10000)
+                {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    out += static_cast<char>(0xF0 | (code >> 18));
+                    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: out += ch; break; // '"', '\\' and '/'
+            }
+        }
+        if (pos >= line.size())
+            return false;
+        pos++; // skip closing '"'
+        return true;
+    };
+
+    skipSpace();
+    if (pos >= line.size() || line[pos++] != '{')
+        return false;
+    skipSpace();
+    if (pos < line.size() && line[pos] == '}')
+        return true;
+
+    while (true)
+    {
+        std::pair<std::string, std::string> member;
+        skipSpace();
+        if (!parseString(member.first))
+            return false;
+        skipSpace();
+        if (pos >= line.size() || line[pos++] != ':')
+            return false;
+        skipSpace();
+        if (pos < line.size() && line[pos] == '"')
+        {
+            if (!parseString(member.second))
+                return false;
+        }
+        else
+        {
+            size_t valueEnd = line.find_first_of(",} \t", pos);
+            if (valueEnd == std::string::npos)
+                return false;
+            member.second = line.substr(pos, valueEnd - pos);
+            if (member.second == "null")
+                member.second.clear();
+            pos = valueEnd;
+        }
+        members.push_back(std::move(member));
+
+        skipSpace();
+        if (pos >= line.size())
+            return false;
+        if (line[pos] == '}')
+            return true;
+        if (line[pos++] != ',')
+            return false;
+    }
+}
+
+// CSV field, quoted only when needed
+void WriteCsvString(bufferedio::BufferedWriter &writer, const std::string &str)
+{
+    if (str.find_first_of(",\"\r\n") == std::string::npos)
+    {
+        writer.Write(str);
+        return;
+    }
+
+    writer.Write('"');
+    for (char ch : str)
+    {
+        if (ch == '"')
+            writer.Write('"');
+        writer.Write(ch);
+    }
+    writer.Write('"');
+}
+
+// JSON string with quotes, backslashes and control characters escaped
+void WriteJsonString(bufferedio::BufferedWriter &writer, const std::string &str)
+{
+    writer.Write('"');
+    for (char ch : str)
+    {
+        if (ch == '"' || ch == '\\')
+        {
+            writer.Write('\\');
+            writer.Write(ch);
+        }
+        else if (static_cast<unsigned char>(ch) < 0x20)
+        {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned>(ch));
+            writer.Write(escape);
+        }
+        else
+            writer.Write(ch);
+    }
+    writer.Write('"');
+}
+
+// open the table file, CSV starts with a header row
+ConfTableWriter::ConfTableWriter(const std::string &filePath)
+    : writer(filePath), format(GetConfTableFormat(filePath))
+{
+    if (format != ConfTableFormat::CSV)
+        return;
+
+    writer.Write("porch_name,porch_type");
+    for (auto &it : ConfFields)
+    {
+        writer.Write(',');
+        writer.Write(it.name);
+    }
+    writer.Write('\n');
+}
+
+void ConfTableWriter::Write(const Conf &conf)
+{
+    if (format == ConfTableFormat::CSV)
+    {
+        WriteCsvString(writer, conf.porchName);
+        writer.Write(conf.isDSC ? ",DSC" : ",NonDSC");
+        for (auto &it : ConfFields)
+        {
+            writer.Write(',');
+            writer.WriteFloat(conf.*it.member);
+        }
+        writer.Write('\n');
+    }
+    else if (format == ConfTableFormat::JSONL)
+    {
+        writer.Write("{\"porch_name\":");
+        WriteJsonString(writer, conf.porchName);
+        writer.Write(conf.isDSC ? ",\"porch_type\":\"DSC\"" : ",\"porch_type\":\"NonDSC\"");
+        for (auto &it : ConfFields)
+        {
+            writer.Write(",\"");
+            writer.Write(it.name);
+            writer.Write("\":");
+            float value = conf.*it.member;
+            if (std::isfinite(value))
+                writer.WriteFloat(value);
+            else
+                writer.Write("null"); // JSON has no nan/inf
+        }
+        writer.Write("}\n");
+    }
+}
+
+bool ConfTableWriter::Close()
+{
+    return writer.Close();
+}
+
+// open the table file, CSV columns are matched by the header row
+ConfTableReader::ConfTableReader(const std::string &filePath)
+    : reader(filePath), format(GetConfTableFormat(filePath))
+{
+    Conf defaultConf;
+    for (int i = 0; i < ConfFieldNum; i++)
+        defaultValues[i] = defaultConf.*ConfFields[i].member;
+
+    if (format == ConfTableFormat::Unknown || !reader.IsOpen())
+    {
+        logger::Error("Unable to open table file!");
+        hasError = true;
+        return;
+    }
+
+    if (format == ConfTableFormat::CSV)
+    {
+        lineNum++;
+        if (!reader.ReadLine(lineBuf) || !ParseCsvLine(lineBuf, fields))
+        {
+            logger::Error("missing CSV header row");
+            hasError = true;
+            return;
+        }
+
+        bool hasName = false;
+        for (auto &field : fields)
+        {
+            int column = -3;
+            if (field == "porch_name")
+            {
+                column = -1;
+                hasName = true;
+            }
+            else if (field == "porch_type")
+                column = -2;
+            for (int i = 0; i < ConfFieldNum && column == -3; i++)
+            {
+                if (field == ConfFields[i].name)
+                    column = i;
+            }
+            columnField.push_back(column);
+        }
+
+        if (!hasName)
+        {
+            logger::Error("CSV header row has no porch_name column");
+            hasError = true;
+            return;
+        }
+    }
+
+    isOpen = true;
+}
+
+// read one row, missing values keep the Conf defaults
+bool ConfTableReader::ReadRow(std::string &porchName, bool &isDSC, float values[])
+{
+    if (!isOpen || hasError)
+        return false;
+
+    do
+    {
+        lineNum++;
+        if (!reader.ReadLine(lineBuf))
+            return false;
+    } while (lineBuf.empty());
+
+    // a quoted CSV field may hold line breaks, the record goes on until the quote is closed
+    std::string continuation;
+    while (format == ConfTableFormat::CSV && IsCsvRecordOpen(lineBuf) && reader.ReadLine(continuation))
+    {
+        lineNum++;
+        lineBuf += '\n';
+        lineBuf += continuation;
+    }
+
+    std::copy(defaultValues, defaultValues + ConfFieldNum, values);
+    porchName.clear();
+    isDSC = true;
+
+    auto setValue = [&](int field, const std::string &text) {
+        if (field == -1)
+            porchName = text;
+        else if (field == -2)
+            isDSC = text != "NonDSC";
+        else if (field >= 0 && !text.empty())
+            values[field] = std::strtof(text.c_str(), nullptr);
+    };
+
+    if (format == ConfTableFormat::CSV)
+    {
+        if (!ParseCsvLine(lineBuf, fields) || fields.size() > columnField.size())
+        {
+            logger::Error("incorrect CSV row at line " + std::to_string(lineNum));
+            hasError = true;
+            return false;
+        }
+        for (size_t i = 0; i < fields.size(); i++)
+            setValue(columnField[i], fields[i]);
+    }
+    else
+    {
+        if (!ParseJsonLine(lineBuf, members))
+        {
+            logger::Error("incorrect JSON object at line " + std::to_string(lineNum));
+            hasError = true;
+            return false;
+        }
+        for (auto &member : members)
+        {
+            int field = -3;
+            if (member.first == "porch_name")
+                field = -1;
+            else if (member.first == "porch_type")
+                field = -2;
+            for (int i = 0; i < ConfFieldNum && field == -3; i++)
+            {
+                if (member.first == ConfFields[i].name)
+                    field = i;
+            }
+            setValue(field, member.second);
+        }
+    }
+
+    std::replace(porchName.begin(), porchName.end(), '\r', ' '); // a conf file keeps each name on one line
+    std::replace(porchName.begin(), porchName.end(), '\n', ' ');
+    return true;
+}
+
+size_t ConfTableReader::ReadBatch(ConfBatch &batch, size_t maxRecords)
+{
+    std::string porchName;
+    bool isDSC = true;
+    float values[ConfFieldNum];
+    size_t recordNum = 0;
+    while (recordNum < maxRecords && ReadRow(porchName, isDSC, values))
+    {
+        batch.porchName.push_back(porchName);
+        batch.isDSC.push_back(isDSC);
+        for (int i = 0; i < ConfFieldNum; i++)
+            batch.columns[i].push_back(values[i]);
+        recordNum++;
+    }
+    return recordNum;
+}
+
+bool ConfTableReader::Next(Conf &conf)
+{
+    float values[ConfFieldNum];
+    if (!ReadRow(conf.porchName, conf.isDSC, values))
+        return false;
+
+    for (int i = 0; i < ConfFieldNum; i++)
+        conf.*ConfFields[i].member = values[i];
+    return true;
+}
+
+// remember the size, modification time and ends hash of the file InMemoryData matches
+void MarkInMemoryDataLoaded()
+{
+    struct stat fileStat;
+    if (stat(PorchConfFilePath.c_str(), &fileStat) != 0)
+    {
+        InMemoryDataFileSize = -1;
+        return;
+    }
+
+    InMemoryDataFileSize = static_cast<int64_t>(fileStat.st_size);
+    InMemoryDataFileTime = static_cast<int64_t>(fileStat.st_mtime);
+    InMemoryDataFileHash = utility::HashFileEnds(PorchConfFilePath);
+    InMemoryDataIsRacy = InMemoryDataFileTime >= static_cast<int64_t>(std::time(nullptr));
+}
+
+// rewrite the Porch Conf file from the current snapshot on the thread pool, one write runs at a time
+void SaveLibraryAsync()
+{
+    if (PendingLibrarySave.write.valid())
+    {
+        PendingLibrarySave.isQueued = true;
+        return;
+    }
+
+    snapshot::Publisher<Conf>::Snapshot library = LibrarySnapshots.Load();
+    std::shared_ptr<bool> isWritten = std::make_shared<bool>(false);
+    std::shared_ptr<std::vector<PorchIndexEntry>> index = std::make_shared<std::vector<PorchIndexEntry>>();
+    std::string path = PorchConfFilePath;
+    PendingLibrarySave.isWritten = isWritten;
+    PendingLibrarySave.index = index;
+    PendingLibrarySave.write = threadpool::GlobalPool().Submit([library, isWritten, index, path]() {
+        trace::ScopedSpan span("rewrite conf file");
+        std::ofstream outStream;
+        outStream.open(path, std::ios::out | std::ios::binary); // overwrite the file, binary mode keeps the indexed offsets exact
+        if (!outStream)
+            return;
+        outStream << PorchConfFileHeader << '\n';
+        std::ostringstream recordStream;
+        uint64_t offset = PorchConfFileHeader.size() + 1;
+        index->reserve(library->Size());
+        for (size_t i = 0; i < library->Size(); i++)
+            WritePorchConfRecord(outStream, (*library)[i], recordStream, offset, *index);
+        outStream.close();
+        *isWritten = !outStream.fail();
+    });
+}
+
+// finish the background rewrite, isWait blocks until it ends, true when the file holds InMemoryData
+bool PollLibrarySave(bool isWait)
+{
+    while (PendingLibrarySave.write.valid())
+    {
+        if (!isWait && PendingLibrarySave.write.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
+        PendingLibrarySave.write.get();
+        if (!*PendingLibrarySave.isWritten)
+        {
+            logger::Error("Unable to open Porch Conf file!");
+            PendingLibrarySave.isQueued = false;
+            InMemoryDataFileSize = -1; // reload what the file holds on next access
+            return true;
+        }
+        if (PendingLibrarySave.isQueued)
+        {
+            PendingLibrarySave.isQueued = false;
+            SaveLibraryAsync();
+            continue;
+        }
+        MarkInMemoryDataLoaded();
+        SetPorchIndex(*PendingLibrarySave.index); // built by the worker from the bytes it wrote
+    }
+    return true;
+}
+
+// ConfFields index of a field name (case insensitive), -1 if not found
+int FindConfField(const std::string &name)
+{
+    for (int i = 0; i < ConfFieldNum; i++)
+    {
+        const char *fieldName = ConfFields[i].name;
+        if (name.size() == std::strlen(fieldName) &&
+            std::equal(name.begin(), name.end(), fieldName, [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); }))
+            return i;
+    }
+    return -1;
+}
+
+// parse "field=lower..upper field=lower.. field=..upper field=value", terms are separated by spaces or commas
+bool ParseRangeQuery(const std::string &text, std::vector<RangeQueryTerm> &terms, std::string &message)
+{
+    terms.clear();
+
+    auto parseNumber = [](const std::string &str, float &value) {
+        if (str.empty())
+            return false;
+        char *end = nullptr;
+        value = std::strtof(str.c_str(), &end);
+        return end == str.c_str() + str.size();
+    };
+
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t begin = text.find_first_not_of(" \t,", pos);
+        if (begin == std::string::npos)
+            break;
+        size_t end = text.find_first_of(" \t,", begin);
+        if (end == std::string::npos)
+            end = text.size();
+        pos = end;
+
+        std::string token = text.substr(begin, end - begin);
+        size_t equal = token.find('=');
+        if (equal == std::string::npos)
+        {
+            message = "missing '=' in \"" + token + "\"";
+            return false;
+        }
+
+        RangeQueryTerm term;
+        term.field = FindConfField(token.substr(0, equal));
+        if (term.field < 0)
+        {
+            message = "unknown field \"" + token.substr(0, equal) + "\"";
+            return false;
+        }
+
+        std::string range = token.substr(equal + 1);
+        size_t dots = range.find("..");
+        bool isValid = true;
+        if (dots == std::string::npos)
+        {
+            isValid = parseNumber(range, term.lower);
+            term.upper = term.lower;
+        }
+        else
+        {
+            std::string lower = range.substr(0, dots);
+            std::string upper = range.substr(dots + 2);
+            if (!lower.empty())
+                isValid = isValid && parseNumber(lower, term.lower);
+            if (!upper.empty())
+                isValid = isValid && parseNumber(upper, term.upper);
+        }
+
+        if (!isValid || !(term.lower <= term.upper))
+        {
+            message = "invalid range in \"" + token + "\"";
+            return false;
+        }
+
+        terms.push_back(term);
+    }
+
+    return true;
+}
+
+// check every term against the record, no index needed
+bool MatchRangeQuery(const Conf &conf, const std::vector<RangeQueryTerm> &terms)
+{
+    for (auto &it : terms)
+    {
+        float value = conf.*ConfFields[it.field].member;
+        if (!(value >= it.lower && value <= it.upper))
+            return false;
+    }
+    return true;
+}
+
+constexpr uint32_t RecordIds::RemovedPosition;
+
+void RecordIds::Reset(size_t size)
+{
+    ids.resize(size);
+    for (uint32_t i = 0; i < size; i++)
+        ids[i] = i;
+    positions = ids;
+    isStale = false;
+}
+
+uint32_t RecordIds::Insert(uint32_t position)
+{
+    uint32_t id = static_cast<uint32_t>(positions.size()); // positions always has one entry per id
+    ids.insert(ids.begin() + std::min<size_t>(position, ids.size()), id);
+    positions.push_back(RemovedPosition);
+    isStale = true;
+    return id;
+}
+
+uint32_t RecordIds::Erase(uint32_t position)
+{
+    uint32_t id = ids[position];
+    ids.erase(ids.begin() + position);
+    isStale = true;
+    return id;
+}
+
+// one pass over the ids after any number of edits, only the lookups pay for it
+uint32_t RecordIds::Position(uint32_t id) const
+{
+    if (isStale)
+    {
+        positions.assign(positions.size(), RemovedPosition);
+        for (uint32_t i = 0; i < ids.size(); i++)
+            positions[ids[i]] = i;
+        isStale = false;
+    }
+    return id < positions.size() ? positions[id] : RemovedPosition;
+}
+
+void ConfRangeIndex::Build(const std::vector<Conf> &data)
+{
+    for (int i = 0; i < ConfFieldNum; i++)
+    {
+        entries[i].clear();
+        isIndexed[i] = std::find_if(std::begin(RangeIndexFieldNames), std::end(RangeIndexFieldNames), [i](const char *name) {
+                           return std::strcmp(name, ConfFields[i].name) == 0;
+                       }) != std::end(RangeIndexFieldNames);
+        if (!isIndexed[i])
+            continue;
+
+        entries[i].reserve(data.size());
+        for (uint32_t id = 0; id < data.size(); id++)
+        {
+            float value = data[id].*ConfFields[i].member;
+            if (!std::isnan(value)) // nan never matches a range and breaks the ordering
+                entries[i].emplace_back(value, id);
+        }
+        std::sort(entries[i].begin(), entries[i].end());
+    }
+    version++;
+}
+
+// one binary search per indexed field, ids of other records stay as they are
+void ConfRangeIndex::Insert(uint32_t id, const Conf &conf)
+{
+    for (int i = 0; i < ConfFieldNum; i++)
+    {
+        float value = conf.*ConfFields[i].member;
+        if (!isIndexed[i] || std::isnan(value))
+            continue;
+
+        Entry entry(value, id);
+        entries[i].insert(std::upper_bound(entries[i].begin(), entries[i].end(), entry), entry);
+    }
+    version++;
+}
+
+void ConfRangeIndex::Erase(uint32_t id, const Conf &conf)
+{
+    for (int i = 0; i < ConfFieldNum; i++)
+    {
+        float value = conf.*ConfFields[i].member;
+        if (!isIndexed[i] || std::isnan(value))
+            continue;
+
+        auto it = std::lower_bound(entries[i].begin(), entries[i].end(), Entry(value, id));
+        if (it != entries[i].end() && it->second == id)
+            entries[i].erase(it);
+    }
+    version++;
+}
+
+// the most selective indexed term gives the candidates, the other terms are checked on the records
+// the candidates are not sorted, a broad filter costs no more than listing its records
+void ConfRangeIndex::Query(const std::vector<Conf> &data, const RecordIds &recordIds, const std::vector<RangeQueryTerm> &terms, std::vector<uint32_t> &result) const
+{
+    result.clear();
+
+    const std::vector<Entry> *bestEntries = nullptr;
+    std::vector<Entry>::const_iterator bestBegin, bestEnd;
+    for (auto &it : terms)
+    {
+        if (!isIndexed[it.field])
+            continue;
+
+        const std::vector<Entry> &fieldEntries = entries[it.field];
+        auto begin = std::lower_bound(fieldEntries.begin(), fieldEntries.end(), Entry(it.lower, 0));
+        auto end = std::upper_bound(begin, fieldEntries.end(), Entry(it.upper, UINT32_MAX));
+        if (bestEntries == nullptr || end - begin < bestEnd - bestBegin)
+        {
+            bestEntries = &fieldEntries;
+            bestBegin = begin;
+            bestEnd = end;
+        }
+    }
+
+    if (bestEntries == nullptr) // no indexed term, scan all records
+    {
+        for (uint32_t id = 0; id < data.size(); id++)
+        {
+            if (MatchRangeQuery(data[id], terms))
+                result.push_back(id);
+        }
+        return;
+    }
+
+    result.reserve(static_cast<size_t>(bestEnd - bestBegin));
+    for (auto it = bestBegin; it != bestEnd; it++)
+    {
+        uint32_t position = recordIds.Position(it->second);
+        if (position < data.size() && MatchRangeQuery(data[position], terms))
+            result.push_back(position);
+    }
+}
+
+// scale every field by its standard deviation over data so each contributes evenly to the distance
+void ConfSimilarIndex::Build(const std::vector<Conf> &data)
+{
+    for (size_t i = 0; i < SimilarFieldNum; i++)
+    {
+        fields[i] = FindConfField(SimilarFieldNames[i]);
+
+        double sum = 0.0, squareSum = 0.0;
+        size_t valueNum = 0;
+        for (auto &conf : data)
+        {
+            float value = conf.*ConfFields[fields[i]].member;
+            if (std::isfinite(value))
+            {
+                sum += value;
+                squareSum += static_cast<double>(value) * value;
+                valueNum++;
+            }
+        }
+        double variance = valueNum > 0 ? squareSum / valueNum - (sum / valueNum) * (sum / valueNum) : 0.0;
+        scales[i] = variance > 0.0 ? static_cast<float>(1.0 / std::sqrt(variance)) : 1.0f;
+    }
+
+    std::vector<kdtree::KdTree<SimilarFieldNum>::Point> points;
+    points.reserve(data.size());
+    for (auto &conf : data)
+        points.push_back(ToPoint(conf));
+    tree.Build(points);
+    version++;
+}
+
+void ConfSimilarIndex::Insert(uint32_t id, const Conf &conf)
+{
+    tree.Insert(id, ToPoint(conf));
+    version++;
+}
+
+void ConfSimilarIndex::Erase(uint32_t id)
+{
+    tree.Erase(id);
+    version++;
+}
+
+void ConfSimilarIndex::Query(const Conf &conf, const RecordIds &recordIds, size_t k, std::vector<Neighbor> &result) const
+{
+    kdtree::KdTree<SimilarFieldNum>::Point weights;
+    for (size_t i = 0; i < SimilarFieldNum; i++)
+        weights[i] = std::isfinite(conf.*ConfFields[fields[i]].member) ? 1.0f : 0.0f;
+    tree.KNearest(ToPoint(conf), weights, k, result);
+    for (auto &it : result) // record ids to data indices
+        it.second = recordIds.Position(it.second);
+}
+
+// non finite values (unset inputs) are stored as 0, a query ignores its own non finite fields
+kdtree::KdTree<SimilarFieldNum>::Point ConfSimilarIndex::ToPoint(const Conf &conf) const
+{
+    kdtree::KdTree<SimilarFieldNum>::Point point;
+    for (size_t i = 0; i < SimilarFieldNum; i++)
+    {
+        float value = conf.*ConfFields[fields[i]].member;
+        point[i] = std::isfinite(value) ? value * scales[i] : 0.0f;
+    }
+    return point;
+}
+
+// print the records of a conf file matching a range query
+int RunQueryCommand(const std::string &inPath, const std::string &query)
+{
+    std::vector<RangeQueryTerm> terms;
+    std::string message;
+    if (!ParseRangeQuery(query, terms, message))
+    {
+        logger::Error(message);
+        return 2;
+    }
+
+    PorchConfReader reader(inPath);
+    if (!reader.IsOpen())
+        return 1;
+
+    std::vector<Conf> data;
+    Conf conf;
+    while (reader.Next(conf))
+        data.push_back(conf);
+    if (reader.HasError())
+        return 1;
+
+    RecordIds recordIds;
+    recordIds.Reset(data.size());
+    ConfRangeIndex index;
+    index.Build(data);
+    std::vector<uint32_t> result;
+    index.Query(data, recordIds, terms, result);
+
+    for (auto id : result)
+        std::cout << id << '\t' << data[id].porchName << '\t' << (data[id].isDSC ? "DSC" : "NonDSC") << '\t' << data[id].fps << '\t' << data[id].minimumLaneRateSwitchToLPMode << '\n';
+    std::cout << result.size() << " of " << data.size() << " records match" << std::endl;
+    return 0;
+}
+
+// payload as written to the file: type plus every number at 6 significant digits, -0 as 0 and one nan
+void CanonicalizeConfPayload(const Conf &conf, float payload[])
+{
+    for (int i = 0; i < ConfFieldNum; i++)
+    {
+        float value = conf.*ConfFields[i].member;
+        if (std::isnan(value))
+            value = std::numeric_limits<float>::quiet_NaN();
+        else if (value == 0.0f)
+            value = 0.0f;
+        else if (!(std::fabs(value) < 1e6f && value == std::trunc(value))) // integers below 1e6 are printed exactly
+        {
+            char number[32];
+            std::snprintf(number, sizeof(number), "%.6g", value);
+            value = std::strtof(number, nullptr);
+        }
+        payload[i] = value;
+    }
+}
+
+uint64_t HashConfPayload(const Conf &conf)
+{
+    float payload[ConfFieldNum];
+    CanonicalizeConfPayload(conf, payload);
+    char type = conf.isDSC ? 1 : 0;
+    uint64_t hash = utility::HashFNV1a64(&type, 1);
+    return utility::HashFNV1a64(reinterpret_cast<const char *>(payload), sizeof(payload), hash);
+}
+
+// hash every record, large sets are split into chunks on the thread pool
+void HashConfPayloads(const std::vector<Conf> &data, std::vector<uint64_t> &hashes)
+{
+    hashes.resize(data.size());
+    if (data.size() < ParallelHashMinRecordNum)
+    {
+        for (size_t i = 0; i < data.size(); i++)
+            hashes[i] = HashConfPayload(data[i]);
+        return;
+    }
+
+    threadpool::ThreadPool &pool = threadpool::GlobalPool();
+    size_t grainSize = (data.size() + pool.Size() * 4 - 1) / (pool.Size() * 4); // a few slices per worker
+    pool.ParallelFor(0, data.size(), grainSize, [&data, &hashes](size_t first, size_t last) {
+        trace::ScopedSpan span("hash payloads");
+        for (size_t i = first; i < last; i++)
+            hashes[i] = HashConfPayload(data[i]);
+    });
+}
+
+bool IsSameConfPayload(const Conf &a, const Conf &b)
+{
+    if (a.isDSC != b.isDSC)
+        return false;
+
+    float payloadA[ConfFieldNum], payloadB[ConfFieldNum];
+    CanonicalizeConfPayload(a, payloadA);
+    CanonicalizeConfPayload(b, payloadB);
+    return std::memcmp(payloadA, payloadB, sizeof(payloadA)) == 0; // bitwise, so nan equals nan
+}
+
+// collapse records with the same payload into the first one, the other names become its aliases
+// erased/inserted optionally receive the change as a history edit, returns the number of records removed
+size_t DedupeConfs(std::vector<Conf> &data, std::vector<std::pair<uint32_t, Conf>> *erased, std::vector<std::pair<uint32_t, Conf>> *inserted)
+{
+    trace::ScopedSpan span("dedupe confs");
+    std::vector<uint64_t> hashes;
+    HashConfPayloads(data, hashes);
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> kept; // hash -> indices of kept records
+    kept.reserve(data.size());
+    std::vector<uint32_t> keptFrom;  // index before the dedupe of each changed kept record
+    std::vector<char> isChanged;     // kept record got new aliases
+    size_t keptNum = 0;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        std::vector<uint32_t> &bucket = kept[hashes[i]];
+        auto same = std::find_if(bucket.begin(), bucket.end(), [&](uint32_t id) { return IsSameConfPayload(data[id], data[i]); });
+        if (same == bucket.end())
+        {
+            if (keptNum != i)
+                data[keptNum] = std::move(data[i]);
+            bucket.push_back(static_cast<uint32_t>(keptNum++));
+            if (erased != nullptr)
+            {
+                keptFrom.push_back(static_cast<uint32_t>(i));
+                isChanged.push_back(0);
+            }
+            continue;
+        }
+
+        Conf &target = data[*same];
+        if (erased != nullptr)
+        {
+            if (!isChanged[*same]) // the old version of the kept record is replaced
+            {
+                erased->emplace_back(keptFrom[*same], target);
+                isChanged[*same] = 1;
+            }
+            erased->emplace_back(static_cast<uint32_t>(i), data[i]);
+        }
+        auto addAlias = [&target](const std::string &name) {
+            if (name != target.porchName && std::find(target.aliases.begin(), target.aliases.end(), name) == target.aliases.end())
+                target.aliases.push_back(name);
+        };
+        addAlias(data[i].porchName);
+        for (auto &it : data[i].aliases)
+            addAlias(it);
+    }
+
+    size_t removedNum = data.size() - keptNum;
+    data.resize(keptNum);
+
+    if (erased != nullptr)
+    {
+        std::sort(erased->begin(), erased->end(), [](const std::pair<uint32_t, Conf> &a, const std::pair<uint32_t, Conf> &b) { return a.first < b.first; });
+        for (uint32_t i = 0; i < keptNum; i++)
+        {
+            if (isChanged[i] && inserted != nullptr)
+                inserted->emplace_back(i, data[i]);
+        }
+    }
+    return removedNum;
+}
+
+// dedupe the library and rewrite the file when anything was merged
+bool DedupeInMemoryData()
+{
+    if (!LoadPorchConfFile())
+        return false;
+
+    HistoryEdit edit;
+    if (DedupeConfs(InMemoryData, &edit.erased, &edit.inserted) == 0)
+        return true;
+
+    BuildInMemoryIndexes(); // record indices changed
+    EditHistory.Push(std::move(edit));
+    return SaveToPorchConfFile();
+}
+
+void ConfPayloadIndex::Build(const std::vector<Conf> &data)
+{
+    std::vector<uint64_t> hashes;
+    HashConfPayloads(data, hashes);
+
+    ids.clear();
+    ids.reserve(data.size());
+    for (uint32_t id = 0; id < data.size(); id++)
+        ids[hashes[id]].push_back(id);
+}
+
+// one hash lookup, a bucket only holds the records sharing the hash
+void ConfPayloadIndex::Insert(uint32_t id, const Conf &conf)
+{
+    ids[HashConfPayload(conf)].push_back(id);
+}
+
+void ConfPayloadIndex::Erase(uint32_t id, const Conf &conf)
+{
+    auto found = ids.find(HashConfPayload(conf));
+    if (found == ids.end())
+        return;
+
+    found->second.erase(std::remove(found->second.begin(), found->second.end(), id), found->second.end());
+    if (found->second.empty())
+        ids.erase(found);
+}
+
+int ConfPayloadIndex::Find(const std::vector<Conf> &data, const RecordIds &recordIds, const Conf &conf) const
+{
+    auto found = ids.find(HashConfPayload(conf));
+    if (found == ids.end())
+        return -1;
+
+    for (auto id : found->second)
+    {
+        uint32_t position = recordIds.Position(id);
+        if (position < data.size() && IsSameConfPayload(data[position], conf))
+            return static_cast<int>(position);
+    }
+    return -1;
+}
+
+// merge the records of a conf file holding the same numbers, the merged names are kept as aliases
+int RunDedupeCommand(const std::string &inPath, const std::string &outPath)
+{
+    PorchConfReader reader(inPath);
+    if (!reader.IsOpen())
+        return 1;
+
+    std::vector<Conf> data;
+    Conf conf;
+    while (reader.Next(conf))
+        data.push_back(conf);
+    if (reader.HasError())
+        return 1;
+
+    size_t recordNum = data.size();
+    size_t removedNum = DedupeConfs(data);
+
+    std::ofstream outStream;
+    outStream.open(outPath, std::ofstream::out); // overwrite the file
+    if (!outStream)
+    {
+        logger::Error("Unable to open output file!");
+        return 1;
+    }
+    outStream << PorchConfFileHeader << '\n';
+    for (auto &it : data)
+        WritePorchConfRecord(outStream, it);
+    outStream.close();
+
+    std::cout << recordNum << " records, " << removedNum << " duplicates merged" << std::endl;
+    return outStream ? 0 : 1;
+}
+
+// sort records into families of similar timings and write them in independently decodable blocks
+bool WriteConfArchive(const std::string &outPath, const std::vector<Conf> &data)
+{
+    trace::ScopedSpan span("write archive");
+    std::vector<int> sortFields;
+    for (auto it : ArchiveSortFieldNames)
+        sortFields.push_back(FindConfField(it));
+
+    std::vector<uint32_t> order(data.size());
+    for (uint32_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        if (data[a].isDSC != data[b].isDSC)
+            return data[a].isDSC < data[b].isDSC;
+        for (auto field : sortFields)
+        {
+            // ordered bits give nan a place in the order
+            int64_t valueA = deltacodec::OrderedFloatBits(data[a].*ConfFields[field].member);
+            int64_t valueB = deltacodec::OrderedFloatBits(data[b].*ConfFields[field].member);
+            if (valueA != valueB)
+                return valueA < valueB;
+        }
+        return false;
+    });
+
+    size_t blockNum = (data.size() + ArchiveBlockSize - 1) / ArchiveBlockSize;
+    std::vector<std::string> blocks(blockNum);
+    threadpool::GlobalPool().ParallelFor(0, blockNum, 1, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++)
+        {
+            size_t begin = i * ArchiveBlockSize;
+            EncodeArchiveBlock(data, order.data() + begin, std::min(ArchiveBlockSize, data.size() - begin), blocks[i]);
+        }
+    });
+
+    std::ofstream outStream;
+    outStream.open(outPath, std::ios::out | std::ios::binary); // overwrite the file
+    if (!outStream)
+    {
+        logger::Error("Unable to open output file!");
+        return false;
+    }
+
+    uint64_t recordNum = data.size();
+    uint32_t blockNum32 = static_cast<uint32_t>(blockNum);
+    outStream.write(PorchArchiveMagic, sizeof(PorchArchiveMagic));
+    outStream.write(reinterpret_cast<const char *>(&PorchArchiveVersion), sizeof(PorchArchiveVersion));
+    outStream.write(reinterpret_cast<const char *>(&recordNum), sizeof(recordNum));
+    outStream.write(reinterpret_cast<const char *>(&blockNum32), sizeof(blockNum32));
+    for (auto &it : blocks)
+    {
+        uint32_t blockSize = static_cast<uint32_t>(it.size());
+        outStream.write(reinterpret_cast<const char *>(&blockSize), sizeof(blockSize));
+        outStream.write(it.data(), it.size());
+    }
+
+    outStream.close();
+    return static_cast<bool>(outStream);
+}
+
+// read an archive back into file order, blocks are decoded on the thread pool
+bool ReadConfArchive(const std::string &inPath, std::vector<Conf> &data)
+{
+    trace::ScopedSpan span("read archive");
+    data.clear();
+
+    std::ifstream inStream;
+    inStream.open(inPath, std::ios::in | std::ios::binary);
+    if (!inStream)
+    {
+        logger::Error("Unable to open archive file!");
+        return false;
+    }
+
+    inStream.seekg(0, std::ios::end);
+    std::string fileBuf(static_cast<size_t>(inStream.tellg()), '\0');
+    inStream.seekg(0, std::ios::beg);
+    inStream.read(&fileBuf[0], fileBuf.size());
+    inStream.close();
+
+    char magic[4] = {};
+    uint32_t version = 0;
+    uint64_t recordNum = 0;
+    uint32_t blockNum = 0;
+    size_t headerSize = sizeof(magic) + sizeof(version) + sizeof(recordNum) + sizeof(blockNum);
+    if (fileBuf.size() >= headerSize)
+    {
+        const char *pos = fileBuf.data();
+        std::memcpy(magic, pos, sizeof(magic));
+        std::memcpy(&version, pos + 4, sizeof(version));
+        std::memcpy(&recordNum, pos + 8, sizeof(recordNum));
+        std::memcpy(&blockNum, pos + 16, sizeof(blockNum));
+    }
+    if (!std::equal(magic, magic + 4, PorchArchiveMagic) || version != PorchArchiveVersion || recordNum > fileBuf.size())
+    {
+        logger::Error("incorrect archive file format");
+        return false;
+    }
+
+    std::vector<std::pair<size_t, size_t>> blockRanges;
+    size_t pos = headerSize;
+    for (uint32_t i = 0; i < blockNum; i++)
+    {
+        uint32_t blockSize = 0;
+        if (fileBuf.size() - pos < sizeof(blockSize))
+            break;
+        std::memcpy(&blockSize, fileBuf.data() + pos, sizeof(blockSize));
+        pos += sizeof(blockSize);
+        if (fileBuf.size() - pos < blockSize)
+            break;
+        blockRanges.emplace_back(pos, pos + blockSize);
+        pos += blockSize;
+    }
+    if (blockRanges.size() != blockNum)
+    {
+        logger::Error("incorrect archive file format");
+        return false;
+    }
+
+    std::vector<std::vector<std::pair<uint32_t, Conf>>> blockRecords(blockNum);
+    std::vector<char> blockResult(blockNum, 0);
+    threadpool::GlobalPool().ParallelFor(0, blockNum, 1, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++)
+            blockResult[i] = DecodeArchiveBlock(fileBuf.data() + blockRanges[i].first, fileBuf.data() + blockRanges[i].second, blockRecords[i]);
+    });
+
+    // every index of [0, recordNum) must be filled exactly once
+    bool isValid = std::find(blockResult.begin(), blockResult.end(), 0) == blockResult.end();
+    std::vector<char> isFilled(isValid ? recordNum : 0, 0);
+    data.resize(isFilled.size());
+    size_t filledNum = 0;
+    for (auto &block : blockRecords)
+    {
+        for (auto &it : block)
+        {
+            if (!isValid || it.first >= recordNum || isFilled[it.first])
+            {
+                isValid = false;
+                break;
+            }
+            isFilled[it.first] = 1;
+            data[it.first] = std::move(it.second);
+            filledNum++;
+        }
+    }
+
+    if (!isValid || filledNum != recordNum)
+    {
+        data.clear();
+        logger::Error("incorrect archive file format");
+        return false;
+    }
+    return true;
+}
+
+// block layout: record count, original indices, type bits, front coded names, then one delta encoded column per ConfFields entry
+void EncodeArchiveBlock(const std::vector<Conf> &data, const uint32_t *order, size_t count, std::string &out)
+{
+    trace::ScopedSpan span("encode archive block");
+    deltacodec::WriteVarint(out, count);
+
+    std::vector<int64_t> column(count);
+    for (size_t j = 0; j < count; j++)
+        column[j] = order[j];
+    deltacodec::EncodeDeltas(column.data(), count, out);
+
+    std::string typeBits((count + 7) / 8, '\0');
+    for (size_t j = 0; j < count; j++)
+    {
+        if (data[order[j]].isDSC)
+            typeBits[j / 8] |= static_cast<char>(1 << (j % 8));
+    }
+    out += typeBits;
+
+    // names of a family usually share a long prefix with the previous one
+    std::string previous;
+    for (size_t j = 0; j < count; j++)
+    {
+        const Conf &conf = data[order[j]];
+        size_t shared = 0;
+        while (shared < previous.size() && shared < conf.porchName.size() && previous[shared] == conf.porchName[shared])
+            shared++;
+        deltacodec::WriteVarint(out, shared);
+        deltacodec::WriteVarint(out, conf.porchName.size() - shared);
+        out.append(conf.porchName, shared, std::string::npos);
+        previous = conf.porchName;
+
+        deltacodec::WriteVarint(out, conf.aliases.size());
+        for (auto &it : conf.aliases)
+        {
+            deltacodec::WriteVarint(out, it.size());
+            out += it;
+        }
+    }
+
+    // a column is stored as integers at the smallest decimal scale that reads back bit exact, otherwise as float bits
+    auto toScaled = [](float value, int scale, int64_t &scaled) {
+        double product = static_cast<double>(value) * ArchiveDecimalScales[scale];
+        if (!(std::fabs(product) < 9e15)) // also rejects nan and infinity
+            return false;
+        scaled = std::llround(product);
+        float back = static_cast<float>(static_cast<double>(scaled) / ArchiveDecimalScales[scale]);
+        return std::memcmp(&back, &value, sizeof(value)) == 0;
+    };
+    for (int i = 0; i < ConfFieldNum; i++)
+    {
+        uint8_t mode = ArchiveFloatBitsMode;
+        for (int scale = 0; scale < static_cast<int>(sizeof(ArchiveDecimalScales) / sizeof(ArchiveDecimalScales[0])); scale++)
+        {
+            size_t j = 0;
+            while (j < count && toScaled(data[order[j]].*ConfFields[i].member, scale, column[j]))
+                j++;
+            if (j == count)
+            {
+                mode = static_cast<uint8_t>(scale);
+                break;
+            }
+        }
+
+        if (mode == ArchiveFloatBitsMode)
+        {
+            for (size_t j = 0; j < count; j++)
+                column[j] = deltacodec::OrderedFloatBits(data[order[j]].*ConfFields[i].member);
+        }
+        out.push_back(static_cast<char>(mode));
+        deltacodec::EncodeDeltas(column.data(), count, out);
+    }
+}
+
+bool DecodeArchiveBlock(const char *pos, const char *end, std::vector<std::pair<uint32_t, Conf>> &records)
+{
+    trace::ScopedSpan span("decode archive block");
+    uint64_t count = 0;
+    if (!deltacodec::ReadVarint(pos, end, count) || count > static_cast<uint64_t>(end - pos))
+        return false;
+
+    records.resize(count);
+    std::vector<int64_t> column(count);
+    if (!deltacodec::DecodeDeltas(pos, end, count, column.data()))
+        return false;
+    for (size_t j = 0; j < count; j++)
+    {
+        if (column[j] < 0 || column[j] > UINT32_MAX)
+            return false;
+        records[j].first = static_cast<uint32_t>(column[j]);
+    }
+
+    if (static_cast<uint64_t>(end - pos) < (count + 7) / 8)
+        return false;
+    for (size_t j = 0; j < count; j++)
+        records[j].second.isDSC = (pos[j / 8] >> (j % 8) & 1) != 0;
+    pos += (count + 7) / 8;
+
+    auto readString = [&](uint64_t size, std::string &str) {
+        if (static_cast<uint64_t>(end - pos) < size)
+            return false;
+        str.append(pos, static_cast<size_t>(size));
+        pos += size;
+        return true;
+    };
+    std::string previous;
+    for (size_t j = 0; j < count; j++)
+    {
+        Conf &conf = records[j].second;
+        uint64_t shared = 0, suffixSize = 0, aliasNum = 0;
+        if (!deltacodec::ReadVarint(pos, end, shared) || shared > previous.size() || !deltacodec::ReadVarint(pos, end, suffixSize))
+            return false;
+        conf.porchName.assign(previous, 0, static_cast<size_t>(shared));
+        if (!readString(suffixSize, conf.porchName))
+            return false;
+        previous = conf.porchName;
+
+        if (!deltacodec::ReadVarint(pos, end, aliasNum) || aliasNum > static_cast<uint64_t>(end - pos))
+            return false;
+        conf.aliases.resize(aliasNum);
+        for (auto &it : conf.aliases)
+        {
+            uint64_t size = 0;
+            if (!deltacodec::ReadVarint(pos, end, size) || !readString(size, it))
+                return false;
+        }
+    }
+
+    for (int i = 0; i < ConfFieldNum; i++)
+    {
+        if (pos == end)
+            return false;
+        uint8_t mode = static_cast<uint8_t>(*pos++);
+        if (!deltacodec::DecodeDeltas(pos, end, count, column.data()))
+            return false;
+
+        float Conf::*member = ConfFields[i].member;
+        if (mode == ArchiveFloatBitsMode)
+        {
+            for (size_t j = 0; j < count; j++)
+                records[j].second.*member = deltacodec::FromOrderedFloatBits(column[j]);
+        }
+        else if (mode < sizeof(ArchiveDecimalScales) / sizeof(ArchiveDecimalScales[0]))
+        {
+            double scale = ArchiveDecimalScales[mode];
+            for (size_t j = 0; j < count; j++)
+                records[j].second.*member = static_cast<float>(static_cast<double>(column[j]) / scale);
+        }
+        else
+            return false;
+    }
+
+    return pos == end;
+}
+
+// write a conf file as a delta compressed archive
+int RunArchiveCommand(const std::string &inPath, const std::string &outPath)
+{
+    PorchConfReader reader(inPath);
+    if (!reader.IsOpen())
+        return 1;
+
+    std::vector<Conf> data;
+    Conf conf;
+    while (reader.Next(conf))
+        data.push_back(conf);
+    if (reader.HasError() || !WriteConfArchive(outPath, data))
+        return 1;
+
+    struct stat inStat, outStat;
+    if (stat(inPath.c_str(), &inStat) == 0 && stat(outPath.c_str(), &outStat) == 0 && outStat.st_size > 0)
+        std::cout << data.size() << " records archived, " << inStat.st_size << " -> " << outStat.st_size << " bytes ("
+                  << std::fixed << std::setprecision(1) << static_cast<double>(inStat.st_size) / outStat.st_size << "x)" << std::endl;
+    return 0;
+}
+
+// write an archive back out as a conf file
+int RunExtractCommand(const std::string &inPath, const std::string &outPath)
+{
+    std::vector<Conf> data;
+    if (!ReadConfArchive(inPath, data))
+        return 1;
+
+    std::ofstream outStream;
+    outStream.open(outPath, std::ofstream::out); // overwrite the file
+    if (!outStream)
+    {
+        logger::Error("Unable to open output file!");
+        return 1;
+    }
+    outStream << PorchConfFileHeader << '\n';
+    for (auto &it : data)
+        WritePorchConfRecord(outStream, it);
+    outStream.close();
+
+    std::cout << data.size() << " records extracted" << std::endl;
+    return outStream ? 0 : 1;
+}
+
+// CPU time and draw data size of one headless frame
+struct BenchFrame
+{
+    int stage = 0;
+    double milliseconds = 0.0;
+    int vertexNum = 0;
+    int indexNum = 0;
+};
+
+// scripted UI frames without a window or GPU: open calculator windows, type their inputs, then show the conf window
+// prints CPU time and draw data size per stage, fails when --max-ms is given and the p99 frame is slower
+int RunBenchCommand(int argc, char *argv[])
+{
+    std::string confPath;
+    int recordNum = 100000;
+    int frameNum = 300;
+    int windowNum = 4;
+    std::string csvPath;
+    double maxMilliseconds = -1.0;
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--conf") == 0 && i + 1 < argc)
+            confPath = argv[++i];
+        else if (std::strcmp(argv[i], "--records") == 0 && i + 1 < argc)
+            recordNum = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frameNum = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--windows") == 0 && i + 1 < argc)
+            windowNum = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+            csvPath = argv[++i];
+        else if (std::strcmp(argv[i], "--max-ms") == 0 && i + 1 < argc)
+            maxMilliseconds = std::atof(argv[++i]);
+        else
+        {
+            PrintCommandLineUsage();
+            return 2;
+        }
+    }
+    if (recordNum < 0 || frameNum < 3 || windowNum < 0 || windowNum > MaxDSCWindowNum + MaxNonDSCWindowNum)
+    {
+        PrintCommandLineUsage();
+        return 2;
+    }
+
+    // the user's library, its sidecar index and the font cache are never written
+    if (!confPath.empty())
+    {
+        if (!CopyBenchLibrary(confPath))
+            return 1;
+    }
+    else
+    {
+        PorchConfFilePath = PorchBenchFilePath;
+        PorchIndexFilePath = PorchBenchIndexFilePath;
+        fontcache::CachePath.clear();
+
+        std::ofstream outStream;
+        outStream.open(PorchConfFilePath, std::ofstream::out);
+        if (!outStream)
+        {
+            logger::Error("Unable to write " + PorchConfFilePath);
+            return 1;
+        }
+        outStream << PorchConfFileHeader << '\n';
+        for (int i = 0; i < recordNum; i++)
+        {
+            Conf conf;
+            conf.porchName = "bench " + std::to_string(i);
+            conf.isDSC = i % 2 == 0;
+            conf.txvid = 300.0f + i % 97;
+            conf.hactive = 1080.0f;
+            conf.vactive = 2400.0f + i % 7;
+            conf.htotal = 1180.0f + i % 13;
+            conf.vtotal = 2550.0f;
+            conf.adjVactive = 2400.0f;
+            conf.adjHactive = 1080.0f;
+            conf.HFP = 20.0f + i % 11;
+            conf.HSYNC = 10.0f;
+            conf.HBP = 30.0f;
+            RecomputeConf(conf);
+            WritePorchConfRecord(outStream, conf);
+        }
+        outStream.close();
+    }
+
+    utility::HeadlessInit(1920, 1080);
+    utility::GUILoadFont(UIGlyphText);
+    if (!LoadPorchConfFile())
+    {
+        utility::HeadlessDestroy();
+        std::remove(PorchConfFilePath.c_str());
+        return 1;
+    }
+
+    const char *const StageNames[] = {"open windows", "type inputs", "conf window"};
+    const char *const TypedInputs[] = {"300", "1080", "2400", "1180", "2550", "2400", "1080", "20", "10", "30"}; // DSCInput order
+    std::vector<BenchFrame> frames(frameNum);
+    std::vector<std::string> typedWindows; // names of the opened calculator windows, typed into one after another
+    int typedNum = 0;
+
+    for (int frame = 0; frame < frameNum; frame++)
+    {
+        // script, applied between frames like the input events of a real frame
+        int stage = frame * 3 / frameNum;
+        if (frame < windowNum)
+        {
+            if (frame % 2 == 0)
+                AddDSCWindow("bench " + std::to_string(frame));
+            else
+                AddNonDSCWindow("bench " + std::to_string(frame));
+            typedWindows.push_back("bench " + std::to_string(frame) + (frame % 2 == 0 ? " | DSC" : " | NonDSC"));
+        }
+        if (stage == 1 && !typedWindows.empty()) // one key event per frame through the focused InputText, the way a user fills a calculator
+        {
+            const int StepNum = 33 + 10 * 2; // 33 characters in TypedInputs, tab down and up before each field
+            int step = typedNum % StepNum, field = 0;
+            const std::string &windowName = typedWindows[typedNum++ / StepNum % typedWindows.size()];
+            while (step >= static_cast<int>(std::strlen(TypedInputs[field])) + 2)
+                step -= static_cast<int>(std::strlen(TypedInputs[field++])) + 2;
+            if (step == 0 && field == 0) // tab into the first input of the window, tabbing selects the old text so it is typed over
+                ImGui::SetWindowFocus(windowName.c_str());
+            if (step < 2)
+                ImGui::GetIO().AddKeyEvent(ImGuiKey_Tab, step == 0);
+            else
+                ImGui::GetIO().AddInputCharacter(TypedInputs[field][step - 2]);
+        }
+        porchFileIsOpen = stage == 2;
+
+        auto start = std::chrono::steady_clock::now();
+        utility::HeadlessNewFrame(1.0f / 60.0f);
+        MainWindowFunction();
+        ImDrawData *drawData = utility::HeadlessEndFrame();
+        auto end = std::chrono::steady_clock::now();
+
+        frames[frame].stage = stage;
+        frames[frame].milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+        frames[frame].vertexNum = drawData->TotalVtxCount;
+        frames[frame].indexNum = drawData->TotalIdxCount;
+    }
+    utility::HeadlessDestroy();
+
+    std::remove(PorchConfFilePath.c_str());
+    std::remove(PorchIndexFilePath.c_str());
+
+    std::cout << recordNum << " records, " << windowNum << " windows, " << frameNum << " frames\n";
+    return ReportBenchFrames(frames, StageNames, 3, csvPath, maxMilliseconds);
+}
+
+// replay a recorded session headless as fast as possible, on a copy of the library so its saves and deletes change nothing
+int RunReplayCommand(int argc, char *argv[])
+{
+    std::string confPath = PorchConfFilePath;
+    std::string csvPath;
+    double maxMilliseconds = -1.0;
+
+    for (int i = 3; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--conf") == 0 && i + 1 < argc)
+            confPath = argv[++i];
+        else if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+            csvPath = argv[++i];
+        else if (std::strcmp(argv[i], "--max-ms") == 0 && i + 1 < argc)
+            maxMilliseconds = std::atof(argv[++i]);
+        else
+        {
+            PrintCommandLineUsage();
+            return 2;
+        }
+    }
+
+    inputrecord::Player player;
+    if (!player.Open(argv[2]))
+    {
+        logger::Error(std::string("Unable to read input recording ") + argv[2]);
+        return 1;
+    }
+    if (utility::HashFileFNV1a64(confPath) != player.LibraryHash()) // clicks would land on other records
+    {
+        logger::Error(confPath + " is not the library the session was recorded with, pass that library with --conf");
+        return 1;
+    }
+    if (!CopyBenchLibrary(confPath))
+        return 1;
+
+    // same scale, window layout and library as the recorded session
+    utility::HeadlessInit(utility::WindowBaseWidth, utility::WindowBaseHeight);
+    ImGui::LoadIniSettingsFromMemory(player.IniText().c_str(), player.IniText().size());
+    utility::WindowScaleFactor = player.ScaleFactor();
+    utility::GUILoadFont(UIGlyphText);
+    LoadPorchConfFile();
+
+    const char *const StageNames[] = {"replay"};
+    std::vector<BenchFrame> frames;
+    inputrecord::FrameInput *input = nullptr;
+    while (player.NextFrame(input))
+    {
+        auto start = std::chrono::steady_clock::now();
+        inputrecord::QueueFrame(*input);
+        utility::HeadlessNewFrame(input->deltaTime);
+        MainWindowFunction();
+        ImDrawData *drawData = utility::HeadlessEndFrame();
+        auto end = std::chrono::steady_clock::now();
+
+        frames.emplace_back();
+        frames.back().milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+        frames.back().vertexNum = drawData->TotalVtxCount;
+        frames.back().indexNum = drawData->TotalIdxCount;
+    }
+    utility::HeadlessDestroy();
+
+    std::remove(PorchConfFilePath.c_str());
+    std::remove(PorchIndexFilePath.c_str());
+
+    if (frames.empty())
+    {
+        logger::Error("The input recording holds no frame");
+        return 1;
+    }
+    std::cout << frames.size() << " frames replayed\n";
+    return ReportBenchFrames(frames, StageNames, 1, csvPath, maxMilliseconds);
+}
+
+// copy a library to the bench library path and point the UI at it, a missing library becomes an empty one
+bool CopyBenchLibrary(const std::string &inPath)
+{
+    PorchConfFilePath = PorchBenchFilePath;
+    PorchIndexFilePath = PorchBenchIndexFilePath;
+    fontcache::CachePath.clear();
+
+    std::ifstream inStream;
+    inStream.open(inPath, std::ifstream::in | std::ifstream::binary);
+    std::ofstream outStream;
+    outStream.open(PorchConfFilePath, std::ofstream::out | std::ofstream::binary);
+    if (!outStream)
+    {
+        logger::Error("Unable to write " + PorchConfFilePath);
+        return false;
+    }
+    if (inStream)
+        outStream << inStream.rdbuf();
+    else
+        outStream << PorchConfFileHeader << '\n';
+    outStream.close();
+    return static_cast<bool>(outStream);
+}
+
+// print p50/p99/max frame time and the largest draw data of every stage and of all frames, 1 when the p99 of all frames is above maxMilliseconds
+int ReportBenchFrames(const std::vector<BenchFrame> &frames, const char *const stageNames[], int stageNum, const std::string &csvPath, double maxMilliseconds)
+{
+    if (!csvPath.empty())
+    {
+        std::ofstream outStream;
+        outStream.open(csvPath, std::ofstream::out);
+        outStream << "frame,stage,ms,vertices,indices\n";
+        for (size_t frame = 0; frame < frames.size(); frame++)
+            outStream << frame << ',' << stageNames[frames[frame].stage] << ',' << frames[frame].milliseconds << ','
+                      << frames[frame].vertexNum << ',' << frames[frame].indexNum << '\n';
+    }
+
+    // p50/p99/max over the frames of a stage, stageNum is every frame
+    auto percentile = [](std::vector<double> &values, double p) {
+        size_t rank = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+        std::nth_element(values.begin(), values.begin() + rank, values.end());
+        return values[rank];
+    };
+    double totalP99 = 0.0;
+    std::cout << std::fixed << std::setprecision(3);
+    for (int stage = 0; stage <= stageNum; stage++)
+    {
+        std::vector<double> times;
+        int maxVertexNum = 0, maxIndexNum = 0;
+        for (auto &it : frames)
+        {
+            if (stage != stageNum && it.stage != stage)
+                continue;
+            times.push_back(it.milliseconds);
+            maxVertexNum = std::max(maxVertexNum, it.vertexNum);
+            maxIndexNum = std::max(maxIndexNum, it.indexNum);
+        }
+        if (times.empty())
+            continue;
+        double p50 = percentile(times, 0.5), p99 = percentile(times, 0.99);
+        double maxTime = *std::max_element(times.begin(), times.end());
+        if (stage == stageNum)
+            totalP99 = p99;
+        std::cout << std::setw(14) << (stage == stageNum ? "all" : stageNames[stage]) << ": p50 " << p50 << " ms, p99 " << p99 << " ms, max " << maxTime
+                  << " ms, vertices " << maxVertexNum << ", indices " << maxIndexNum << '\n';
+    }
+
+    if (maxMilliseconds >= 0.0 && totalP99 > maxMilliseconds)
+    {
+        logger::Error("p99 frame time above --max-ms");
+        return 1;
+    }
+    return 0;
+}
+
+// rebuild the range, name, similar timing and payload indexes after InMemoryData is loaded, and publish it
+void BuildInMemoryIndexes()
+{
+    trace::ScopedSpan span("build indexes");
+    LibrarySnapshots.Publish(InMemoryData);
+    InMemoryRecordIds.Reset(InMemoryData.size());
+    InMemoryRangeIndex.Build(InMemoryData);
+    InMemorySimilarIndex.Build(InMemoryData);
+    InMemoryPayloadIndex.Build(InMemoryData);
+
+    InMemoryNameIndex.Clear();
+    for (uint32_t id = 0; id < InMemoryData.size(); id++)
+    {
+        std::string searchName = GetConfSearchName(InMemoryData[id]);
+        InMemoryNameIndex.Add(id, searchName);
+        utility::GUIAddGlyphs(searchName); // names shown in the conf window
+    }
+}
+
+// name plus aliases, merged duplicates stay searchable by their old names
+std::string GetConfSearchName(const Conf &conf)
+{
+    std::string searchName = conf.porchName;
+    for (auto &it : conf.aliases)
+        searchName += " " + it;
+    return searchName;
+}
+
+// erase one record and keep the indexes in sync, later records move down by one but keep their ids
+void EraseInMemoryRecord(uint32_t index)
+{
+    if (index >= InMemoryData.size())
+        return;
+
+    uint32_t id = InMemoryRecordIds.Erase(index);
+    InMemoryRangeIndex.Erase(id, InMemoryData[index]);
+    InMemoryNameIndex.Erase(id);
+    InMemorySimilarIndex.Erase(id);
+    InMemoryPayloadIndex.Erase(id, InMemoryData[index]);
+    InMemoryData.erase(InMemoryData.begin() + index);
+    LibrarySnapshots.Erase(index);
+}
+
+// insert one record under a new id and keep the indexes in sync, later records move up by one but keep their ids
+void InsertInMemoryRecord(uint32_t index, const Conf &conf)
+{
+    if (index > InMemoryData.size())
+        return;
+
+    InMemoryData.insert(InMemoryData.begin() + index, conf);
+    uint32_t id = InMemoryRecordIds.Insert(index);
+    InMemoryRangeIndex.Insert(id, conf);
+    std::string searchName = GetConfSearchName(conf);
+    InMemoryNameIndex.Add(id, searchName);
+    utility::GUIAddGlyphs(searchName);
+    InMemorySimilarIndex.Insert(id, conf);
+    InMemoryPayloadIndex.Insert(id, conf);
+    LibrarySnapshots.Insert(index, conf);
+}
+
+// undo the latest edit, a library edit first reloads a changed file so it never applies to other records
+bool UndoEdit()
+{
+    if (!ReloadForLibraryEdit(EditHistory.NextUndo()))
+        return false;
+    return EditHistory.Undo(ApplyHistoryEdit);
+}
+
+bool RedoEdit()
+{
+    if (!ReloadForLibraryEdit(EditHistory.NextRedo()))
+        return false;
+    return EditHistory.Redo(ApplyHistoryEdit);
+}
+
+// false when the file changed under a library edit, the reload has dropped it and the next press undoes what is left
+bool ReloadForLibraryEdit(const HistoryEdit *edit)
+{
+    if (edit == nullptr || (edit->erased.empty() && edit->inserted.empty()))
+        return true; // input edits do not touch the file
+    uint64_t loadNum = InMemoryDataLoadNum;
+    return LoadPorchConfFile() && loadNum == InMemoryDataLoadNum;
+}
+
+// revert (isUndo) or reapply one edit, the file is rewritten in the background
+bool ApplyHistoryEdit(HistoryEdit &edit, bool isUndo)
+{
+    for (auto &it : edit.inputs)
+    {
+        std::string *input = FindCalculatorInput(it.windowId, it.field);
+        if (input != nullptr)
+            *input = isUndo ? it.before : it.after;
+    }
+
+    if (edit.erased.empty() && edit.inserted.empty())
+        return true;
+
+    bool isApplied = isUndo ? ApplyLibraryEdit(edit.inserted, edit.erased) : ApplyLibraryEdit(edit.erased, edit.inserted);
+    if (isApplied)
+        SaveLibraryAsync();
+    return isApplied;
+}
+
+// record a changed calculator input, inputs outside a calculator window are not recorded
+void PushInputEdit(HistoryEdit &edit, std::string *input, const std::string &before)
+{
+    for (int field = 0; field < 10; field++)
+    {
+        for (int i = 0; i < MaxDSCWindowNum; i++)
+            if (&DSCInputFields[field][i] == input && DSCWindowId[i] != 0)
+                edit.inputs.push_back(InputEdit{DSCWindowId[i], field, before, *input});
+        for (int i = 0; i < MaxNonDSCWindowNum; i++)
+            if (&NonDSCInputFields[field][i] == input && NonDSCWindowId[i] != 0)
+                edit.inputs.push_back(InputEdit{NonDSCWindowId[i], field, before, *input});
+    }
+}
+
+// input buf of an open calculator window, nullptr once the window is closed
+std::string *FindCalculatorInput(uint64_t windowId, int field)
+{
+    for (int i = 0; i < MaxDSCWindowNum; i++)
+        if (DSCWindowId[i] == windowId)
+            return &DSCInputFields[field][i];
+    for (int i = 0; i < MaxNonDSCWindowNum; i++)
+        if (NonDSCWindowId[i] == windowId)
+            return &NonDSCInputFields[field][i];
+    return nullptr;
+}
+
+// forget the inputs of a closed window, edits left empty are dropped
+void DropWindowEdits(uint64_t windowId)
+{
+    EditHistory.Filter([windowId](HistoryEdit &edit) {
+        edit.inputs.erase(std::remove_if(edit.inputs.begin(), edit.inputs.end(), [windowId](const InputEdit &input) { return input.windowId == windowId; }),
+                          edit.inputs.end());
+        return !edit.inputs.empty() || !edit.erased.empty() || !edit.inserted.empty();
+    });
+}
+
+// forget the records of every edit once InMemoryData is replaced, input edits stay
+void DropLibraryEdits()
+{
+    EditHistory.Filter([](HistoryEdit &edit) {
+        edit.erased.clear();
+        edit.inserted.clear();
+        return !edit.inputs.empty();
+    });
+}
+
+// erase records at their indices before the edit, then insert records at their indices after it, both ascending
+bool ApplyLibraryEdit(const std::vector<std::pair<uint32_t, Conf>> &erased, const std::vector<std::pair<uint32_t, Conf>> &inserted)
+{
+    size_t finalSize = InMemoryData.size() - std::min(erased.size(), InMemoryData.size()) + inserted.size();
+    if (erased.size() > InMemoryData.size() ||
+        (!erased.empty() && erased.back().first >= InMemoryData.size()) ||
+        (!inserted.empty() && inserted.back().first >= finalSize))
+    {
+        logger::Error("Edit history does not match Porch Conf data!");
+        InMemoryDataFileSize = -1; // reload on next access
+        return false;
+    }
+
+    // few records: update the indexes in place, nothing else is touched
+    if (erased.size() + inserted.size() <= IncrementalEditMaxRecordNum)
+    {
+        for (auto it = erased.rbegin(); it != erased.rend(); it++)
+            EraseInMemoryRecord(it->first);
+        for (auto &it : inserted)
+            InsertInMemoryRecord(it.first, it.second);
+        return true;
+    }
+
+    // bulk edit: one compaction pass, one merge pass, then rebuild the indexes
+    size_t keptNum = 0;
+    auto erasedIt = erased.begin();
+    for (size_t i = 0; i < InMemoryData.size(); i++)
+    {
+        if (erasedIt != erased.end() && erasedIt->first == i)
+        {
+            erasedIt++;
+            continue;
+        }
+        if (keptNum != i)
+            InMemoryData[keptNum] = std::move(InMemoryData[i]);
+        keptNum++;
+    }
+    InMemoryData.resize(keptNum);
+
+    std::vector<Conf> merged;
+    merged.reserve(finalSize);
+    auto insertedIt = inserted.begin();
+    for (size_t i = 0; merged.size() < finalSize; )
+    {
+        if (insertedIt != inserted.end() && insertedIt->first == merged.size())
+            merged.push_back((insertedIt++)->second);
+        else
+            merged.push_back(std::move(InMemoryData[i++]));
+    }
+    InMemoryData.swap(merged);
+
+    BuildInMemoryIndexes();
+    return true;
+}
+
+// conf with the inputs of a calculator window in ConfFields order, false unless every input is a number
+bool ParseCalculatorInputs(std::string *inputs[], bool isDSC, Conf &conf)
+{
+    conf.isDSC = isDSC;
+    bool isFilled = true;
+    for (int i = 0; i < 10; i++)
+    {
+        char *end = nullptr;
+        conf.*ConfFields[i].member = std::strtof(inputs[i]->c_str(), &end);
+        isFilled = isFilled && !inputs[i]->empty() && end == inputs[i]->c_str() + inputs[i]->size();
+    }
+    return isFilled;
+}
+
+// sweep base's HFP over [from, to] on a background worker, htotal keeps its sum with the porches: htotal - HFP stays fixed
+void StartSweep(const Conf &base, float from, float to, size_t pointNum)
+{
+    CancelSweep();
+    HfpSweep.base = base;
+    HfpSweep.from = from;
+    HfpSweep.step = (static_cast<double>(to) - from) / static_cast<double>(pointNum - 1);
+    HfpSweep.pointNum = pointNum;
+    HfpSweep.token = threadpool::CancellationToken();
+    HfpSweep.queue = std::make_shared<sweepplot::PointQueue>();
+    HfpSweep.fps.Clear();
+    HfpSweep.laneRate.Clear();
+    HfpSweep.fps.Reserve(pointNum);
+    HfpSweep.laneRate.Reserve(pointNum);
+    HfpSweep.view = sweepplot::View();
+    sweepIsOpen = true;
+
+    std::shared_ptr<sweepplot::PointQueue> queue = HfpSweep.queue;
+    threadpool::CancellationToken token = HfpSweep.token;
+    double fromValue = HfpSweep.from;
+    double step = HfpSweep.step;
+    threadpool::GlobalPool().Submit([base, fromValue, step, pointNum, queue, token]() {
+        trace::ScopedSpan span("hfp sweep");
+        Conf conf = base; // only the numbers change, RecomputeConf writes every output
+        std::vector<float> fps, laneRate;
+        fps.reserve(SweepBatchSize);
+        laneRate.reserve(SweepBatchSize);
+        for (size_t first = 0; first < pointNum && !token.IsCancelled(); first += SweepBatchSize)
+        {
+            size_t last = std::min(first + SweepBatchSize, pointNum);
+            fps.clear();
+            laneRate.clear();
+            for (size_t i = first; i < last; i++)
+            {
+                conf.HFP = static_cast<float>(fromValue + step * static_cast<double>(i));
+                conf.htotal = base.htotal + (conf.HFP - base.HFP);
+                RecomputeConf(conf);
+                fps.push_back(conf.fps);
+                laneRate.push_back(conf.minimumLaneRateSwitchToLPMode);
+            }
+            queue->Push(SweepFpsSeries, fps.data(), fps.size());
+            queue->Push(SweepLaneRateSeries, laneRate.data(), laneRate.size());
+        }
+        queue->Finish();
+    }, threadpool::Priority::Background, token);
+}
+
+// stop the running sweep, the points computed so far stay in the plots
+void CancelSweep()
+{
+    HfpSweep.token.Cancel();
+}
+
+// feasibility map of base's inputs, the view starts at [0, 2 * input] on both axes
+void OpenFeasibilityMap(const Conf &base)
+{
+    Feasibility.base = base;
+    ResetFeasibilityMap(true);
+    feasibilityIsOpen = true;
+}
+
+// drop every tile, the inputs or limits they were computed with changed
+void ResetFeasibilityMap(bool isViewReset)
+{
+    FeasibilityMap &map = Feasibility;
+    map.token.Cancel();
+    map.token = threadpool::CancellationToken();
+    map.queue = std::make_shared<heatmap::TileQueue>();
+    map.pending.clear();
+    map.cache.Clear();
+    map.evaluatedNum = 0;
+    map.laneRateLimit = PhyLaneRateLimit;
+    map.isImageDirty = true;
+    if (isViewReset)
+    {
+        double xResolution = map.xField == 0 ? TxvidResolution : 1.0, yResolution = map.yField == 0 ? TxvidResolution : 1.0;
+        map.home.xMin = 0.0;
+        map.home.xMax = 2 * std::max<double>(map.base.*ConfFields[map.xField].member, 32 * xResolution);
+        map.home.yMin = 0.0;
+        map.home.yMax = 2 * std::max<double>(map.base.*ConfFields[map.yField].member, 32 * yResolution);
+        map.view = map.home;
+    }
+}
+
+// inner function, class of base with the two map inputs at grid point (gridX, gridY)
+static uint8_t ClassifyFeasibility(Conf &conf, int xField, int yField, double xResolution, double yResolution, float fpsMin, float fpsMax,
+                                   float laneRateLimit, int64_t gridX, int64_t gridY)
+{
+    float x = static_cast<float>(gridX * xResolution), y = static_cast<float>(gridY * yResolution);
+    if (x < 0 || y < 0 || (xField < 7 && x == 0) || (yField < 7 && y == 0)) // porches may be 0, counts and txvid may not
+        return InvalidInput;
+    conf.*ConfFields[xField].member = x;
+    conf.*ConfFields[yField].member = y;
+    RecomputeConf(conf);
+    if (!std::isfinite(conf.fps) || !std::isfinite(conf.minimumLaneRateSwitchToLPMode))
+        return InvalidInput;
+    uint8_t result = Feasible;
+    if (conf.fps < fpsMin || conf.fps > fpsMax)
+        result |= FpsOutOfRange;
+    if (conf.minimumLaneRateSwitchToLPMode > laneRateLimit)
+        result |= LaneRateOverLimit;
+    return result;
+}
+
+// inner function, refine a tile on a background worker, seeded with the samples its parent and children already have
+static void SubmitFeasibilityTile(const heatmap::TileKey &key)
+{
+    FeasibilityMap &map = Feasibility;
+    heatmap::Tile tile(key);
+    heatmap::TileKey parent = key;
+    parent.xLevel++;
+    parent.yLevel++;
+    parent.x = heatmap::FloorDiv(key.x, 2);
+    parent.y = heatmap::FloorDiv(key.y, 2);
+    if (const heatmap::Tile *it = map.cache.Find(parent))
+        heatmap::Seed(tile, *it);
+    for (int i = 0; i < 4 && key.xLevel > 0 && key.yLevel > 0; i++)
+    {
+        heatmap::TileKey child = key;
+        child.xLevel--;
+        child.yLevel--;
+        child.x = key.x * 2 + i % 2;
+        child.y = key.y * 2 + i / 2;
+        if (const heatmap::Tile *it = map.cache.Find(child))
+            heatmap::Seed(tile, *it);
+    }
+    map.pending.insert(key);
+
+    Conf base = map.base;
+    int xField = map.xField, yField = map.yField;
+    double xResolution = xField == 0 ? TxvidResolution : 1.0, yResolution = yField == 0 ? TxvidResolution : 1.0;
+    float fpsMin = map.fpsRange[0], fpsMax = map.fpsRange[1], laneRateLimit = map.laneRateLimit;
+    std::shared_ptr<heatmap::TileQueue> queue = map.queue;
+    threadpool::GlobalPool().Submit([tile, base, xField, yField, xResolution, yResolution, fpsMin, fpsMax, laneRateLimit, queue]() mutable {
+        trace::ScopedSpan span("feasibility tile");
+        Conf conf = base;
+        auto classify = [&](int64_t gridX, int64_t gridY) {
+            return ClassifyFeasibility(conf, xField, yField, xResolution, yResolution, fpsMin, fpsMax, laneRateLimit, gridX, gridY);
+        };
+        heatmap::Refine(tile, classify);
+        queue->Push(std::move(tile));
+    }, threadpool::Priority::Background, map.token);
+}
+
+// take in finished tiles, queue the missing visible ones coarse to fine and rebuild the texture when anything changed
+void UpdateFeasibilityMap(const ImVec2 &plotSize)
+{
+    FeasibilityMap &map = Feasibility;
+    map.frame++;
+    map.queue->Drain(map.drained);
+    for (heatmap::Tile &it : map.drained)
+    {
+        map.pending.erase(it.key);
+        map.evaluatedNum += it.evaluatedNum;
+        it.lastUsed = map.frame;
+        map.cache.Insert(std::move(it));
+        map.isImageDirty = true;
+    }
+    if (map.cache.Size() > MaxFeasibilityTileNum)
+        map.cache.Evict(MaxFeasibilityTileNum * 3 / 4);
+
+    // visible level: at most one cell per FeasibilityCellPixels pixels on each axis
+    double xResolution = map.xField == 0 ? TxvidResolution : 1.0, yResolution = map.yField == 0 ? TxvidResolution : 1.0;
+    double xCellNum = std::max(16.0, std::floor(static_cast<double>(plotSize.x) / FeasibilityCellPixels));
+    double yCellNum = std::max(16.0, std::floor(static_cast<double>(plotSize.y) / FeasibilityCellPixels));
+    int xLevel = 0, yLevel = 0;
+    while ((map.view.xMax - map.view.xMin) / xResolution / std::ldexp(1.0, xLevel) > xCellNum)
+        xLevel++;
+    while ((map.view.yMax - map.view.yMin) / yResolution / std::ldexp(1.0, yLevel) > yCellNum)
+        yLevel++;
+
+    // coarse levels first, a finer tile waits for its parent so it starts from the parent's samples
+    for (int k = FeasibilityCoarseLevelNum; k >= 0; k--)
+    {
+        double xStep = xResolution * std::ldexp(1.0, xLevel + k), yStep = yResolution * std::ldexp(1.0, yLevel + k);
+        int64_t xFirst = heatmap::FloorDiv(static_cast<int64_t>(std::floor(map.view.xMin / xStep)), heatmap::TileSize);
+        int64_t xLast = heatmap::FloorDiv(static_cast<int64_t>(std::floor(map.view.xMax / xStep)), heatmap::TileSize);
+        int64_t yFirst = heatmap::FloorDiv(static_cast<int64_t>(std::floor(map.view.yMin / yStep)), heatmap::TileSize);
+        int64_t yLast = heatmap::FloorDiv(static_cast<int64_t>(std::floor(map.view.yMax / yStep)), heatmap::TileSize);
+        for (int64_t y = yFirst; y <= yLast; y++)
+        {
+            for (int64_t x = xFirst; x <= xLast && map.pending.size() < MaxFeasibilityPendingNum; x++)
+            {
+                heatmap::TileKey key;
+                key.xLevel = xLevel + k;
+                key.yLevel = yLevel + k;
+                key.x = x;
+                key.y = y;
+                if (heatmap::Tile *it = map.cache.Find(key))
+                {
+                    it->lastUsed = map.frame;
+                    continue;
+                }
+                heatmap::TileKey parent = key;
+                parent.xLevel++;
+                parent.yLevel++;
+                parent.x = heatmap::FloorDiv(x, 2);
+                parent.y = heatmap::FloorDiv(y, 2);
+                if (map.pending.count(key) == 0 && (k == FeasibilityCoarseLevelNum || map.cache.Find(parent) != nullptr))
+                    SubmitFeasibilityTile(key);
+            }
+        }
+    }
+
+    // texture of the visible cells, row 0 is the top
+    double xStep = xResolution * std::ldexp(1.0, xLevel), yStep = yResolution * std::ldexp(1.0, yLevel);
+    heatmap::TileKey imageKey;
+    imageKey.xLevel = xLevel;
+    imageKey.yLevel = yLevel;
+    imageKey.x = static_cast<int64_t>(std::floor(map.view.xMin / xStep));
+    imageKey.y = static_cast<int64_t>(std::floor(map.view.yMin / yStep));
+    int width = static_cast<int>(std::floor(map.view.xMax / xStep) - imageKey.x) + 1;
+    int height = static_cast<int>(std::floor(map.view.yMax / yStep) - imageKey.y) + 1;
+    if (!map.isImageDirty && imageKey == map.imageKey && width == map.imageWidth && height == map.imageHeight)
+        return;
+    map.isImageDirty = false;
+    map.imageKey = imageKey;
+    map.imageWidth = width;
+    map.imageHeight = height;
+    map.image.xMin = imageKey.x * xStep;
+    map.image.xMax = (imageKey.x + width) * xStep;
+    map.image.yMin = imageKey.y * yStep;
+    map.image.yMax = (imageKey.y + height) * yStep;
+
+    map.cache.Read(xLevel, yLevel, imageKey.x, imageKey.y, width, height, FeasibilityFallbackLevelNum, map.frame, map.cells);
+    map.pixels.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+    for (int j = 0; j < height; j++)
+    {
+        const uint8_t *row = &map.cells[static_cast<size_t>(height - 1 - j) * width];
+        uint32_t *out = &map.pixels[static_cast<size_t>(j) * width];
+        for (int i = 0; i < width; i++)
+            out[i] = row[i] == heatmap::Unknown ? 0 : FeasibilityColors[row[i]]; // unknown cells are transparent
+    }
+    utility::GUIUpdateTexture(map.texture, map.pixels.data(), width, height);
+}
+
+// stop the workers and free the texture, the map is computed again when opened
+void CloseFeasibilityMap()
+{
+    FeasibilityMap &map = Feasibility;
+    map.token.Cancel();
+    map.pending.clear();
+    map.cache.Clear();
+    utility::GUIDestroyTexture(map.texture);
+    feasibilityIsOpen = false;
+}